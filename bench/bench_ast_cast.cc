@@ -0,0 +1,172 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "jcc/ast_context.h"
+#include "jcc/casting.h"
+#include "jcc/decl.h"
+#include "jcc/expr.h"
+#include "jcc/identifier_table.h"
+#include "jcc/source_location.h"
+#include "jcc/type.h"
+
+using namespace jcc;
+
+// Builds a balanced expression tree with 2^depth leaves, a mix of integer
+// literals and references to `x`, with every other level negated. `nodes`
+// counts the nodes created.
+static Expr* BuildTree(ASTContext& ctx, VarDecl* var, int depth,
+                       std::int64_t& nodes) {
+  Type* type = ctx.GetIntType();
+  if (nodes++ % 2 == 0 && depth == 0) {
+    return IntergerLiteral::Create(ctx, SourceRange(), type,
+                                   static_cast<int>(nodes));
+  }
+  if (depth == 0) {
+    return DeclRefExpr::Create(ctx, SourceRange(), type, var);
+  }
+  Expr* lhs = BuildTree(ctx, var, depth - 1, nodes);
+  Expr* rhs = BuildTree(ctx, var, depth - 1, nodes);
+  Expr* sum = BinaryExpr::Create(ctx, SourceRange(), type,
+                                 BinaryOperatorKind::Plus, lhs, rhs);
+  if (depth % 2 == 0) {
+    nodes++;
+    return UnaryExpr::Create(ctx, SourceRange(), type, UnaryOperatorKind::Minus,
+                             sum);
+  }
+  return sum;
+}
+
+// A mirror of the tree BuildTree builds, in a hierarchy with a vtable, the
+// way AST nodes used to be, so dynamic_cast has something to walk.
+namespace {
+struct PolyNode {
+  virtual ~PolyNode() = default;
+};
+struct PolyBinary : PolyNode {
+  PolyNode* lhs;
+  PolyNode* rhs;
+};
+struct PolyUnary : PolyNode {
+  PolyNode* value;
+};
+struct PolyLiteral : PolyNode {
+  int value;
+};
+struct PolyRef : PolyNode {};
+}  // namespace
+
+static PolyNode* Mirror(Stmt* stmt,
+                        std::vector<std::unique_ptr<PolyNode>>& nodes) {
+  if (auto* binary = dyn_cast<BinaryExpr>(stmt)) {
+    auto mirror = std::make_unique<PolyBinary>();
+    mirror->lhs = Mirror(binary->GetLhs(), nodes);
+    mirror->rhs = Mirror(binary->GetRhs(), nodes);
+    return nodes.emplace_back(std::move(mirror)).get();
+  }
+  if (auto* unary = dyn_cast<UnaryExpr>(stmt)) {
+    auto mirror = std::make_unique<PolyUnary>();
+    mirror->value = Mirror(unary->GetValue(), nodes);
+    return nodes.emplace_back(std::move(mirror)).get();
+  }
+  if (auto* literal = dyn_cast<IntergerLiteral>(stmt)) {
+    auto mirror = std::make_unique<PolyLiteral>();
+    mirror->value = literal->GetValue();
+    return nodes.emplace_back(std::move(mirror)).get();
+  }
+  return nodes.emplace_back(std::make_unique<PolyRef>()).get();
+}
+
+// Both walkers test the node classes in the same order, the way codegen
+// dispatches on them, so the only difference is how a test is answered.
+static std::int64_t EvalWithDynCast(Stmt* stmt) {
+  if (auto* binary = dyn_cast<BinaryExpr>(stmt)) {
+    return EvalWithDynCast(binary->GetLhs()) +
+           EvalWithDynCast(binary->GetRhs());
+  }
+  if (auto* unary = dyn_cast<UnaryExpr>(stmt)) {
+    return -EvalWithDynCast(unary->GetValue());
+  }
+  if (auto* literal = dyn_cast<IntergerLiteral>(stmt)) {
+    return literal->GetValue();
+  }
+  if (isa<DeclRefExpr>(stmt)) {
+    return 1;
+  }
+  return 0;
+}
+
+static std::int64_t EvalWithRTTI(PolyNode* node) {
+  if (auto* binary = dynamic_cast<PolyBinary*>(node)) {
+    return EvalWithRTTI(binary->lhs) + EvalWithRTTI(binary->rhs);
+  }
+  if (auto* unary = dynamic_cast<PolyUnary*>(node)) {
+    return -EvalWithRTTI(unary->value);
+  }
+  if (auto* literal = dynamic_cast<PolyLiteral*>(node)) {
+    return literal->value;
+  }
+  if (dynamic_cast<PolyRef*>(node) != nullptr) {
+    return 1;
+  }
+  return 0;
+}
+
+static void BM_WalkAST(benchmark::State& state) {
+  IdentifierTable idents;
+  ASTContext ctx(idents);
+  ctx.EnterScope();
+  VarDecl* var = VarDecl::Create(ctx, SourceRange(), nullptr,
+                                 ctx.GetIntType(), &idents.Get("x"));
+  std::int64_t nodes = 0;
+  Expr* root = BuildTree(ctx, var, static_cast<int>(state.range(0)), nodes);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(EvalWithDynCast(root));
+  }
+  state.SetItemsProcessed(state.iterations() * nodes);
+}
+BENCHMARK(BM_WalkAST)->Arg(16);
+
+static void BM_WalkASTWithRTTI(benchmark::State& state) {
+  IdentifierTable idents;
+  ASTContext ctx(idents);
+  ctx.EnterScope();
+  VarDecl* var = VarDecl::Create(ctx, SourceRange(), nullptr,
+                                 ctx.GetIntType(), &idents.Get("x"));
+  std::int64_t nodes = 0;
+  std::vector<std::unique_ptr<PolyNode>> mirror_nodes;
+  PolyNode* root = Mirror(
+      BuildTree(ctx, var, static_cast<int>(state.range(0)), nodes),
+      mirror_nodes);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(EvalWithRTTI(root));
+  }
+  state.SetItemsProcessed(state.iterations() * nodes);
+}
+BENCHMARK(BM_WalkASTWithRTTI)->Arg(16);
+
+// Building and tearing down a whole context. None of these nodes needs its
+// destructor run, so teardown is just freeing the arena chunks.
+static void BM_BuildAST(benchmark::State& state) {
+  IdentifierTable idents;
+  IdentifierInfo* name = &idents.Get("x");
+  std::int64_t nodes = 0;
+
+  for (auto _ : state) {
+    ASTContext ctx(idents);
+    ctx.EnterScope();
+    VarDecl* var = VarDecl::Create(ctx, SourceRange(), nullptr,
+                                   ctx.GetIntType(), name);
+    nodes = 0;
+    benchmark::DoNotOptimize(
+        BuildTree(ctx, var, static_cast<int>(state.range(0)), nodes));
+  }
+  state.SetItemsProcessed(state.iterations() * nodes);
+}
+BENCHMARK(BM_BuildAST)->Arg(16);
+
+BENCHMARK_MAIN();
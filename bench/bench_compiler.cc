@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "c_generator.h"
+#include "jcc/codegen.h"
+#include "jcc/decl.h"
+#include "jcc/identifier_table.h"
+#include "jcc/lexer.h"
+#include "jcc/parser.h"
+#include "jcc/source_manager.h"
+
+using namespace jcc;
+
+// A translation unit of at least `size` bytes, `functions` counts its
+// functions.
+static std::string BuildSource(std::size_t size, std::int64_t& functions) {
+  GeneratedProgram program =
+      GenerateProgram({.functions = 0, .min_size = size});
+  functions = static_cast<std::int64_t>(program.num_functions);
+  return std::move(program.source);
+}
+
+static void BM_Lex(benchmark::State& state) {
+  std::int64_t functions = 0;
+  const std::string source =
+      BuildSource(static_cast<std::size_t>(state.range(0)), functions);
+  SourceManager source_mgr;
+  FileID file = source_mgr.AddBuffer("bench.c", source);
+
+  for (auto _ : state) {
+    IdentifierTable idents;
+    Lexer lexer(source_mgr, file, idents);
+    while (!lexer.Lex().Is<TokenKind::Eof>()) {
+    }
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(source.size()));
+}
+
+static void BM_Parse(benchmark::State& state) {
+  std::int64_t functions = 0;
+  const std::string source =
+      BuildSource(static_cast<std::size_t>(state.range(0)), functions);
+  SourceManager source_mgr;
+  FileID file = source_mgr.AddBuffer("bench.c", source);
+  std::size_t nodes = 0;
+
+  for (auto _ : state) {
+    IdentifierTable idents;
+    Lexer lexer(source_mgr, file, idents);
+    Parser parser(lexer);
+    benchmark::DoNotOptimize(parser.ParseTranslateUnit());
+    nodes = parser.GetASTContext().GetNumNodes();
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(source.size()));
+  state.counters["nodes"] = benchmark::Counter(
+      static_cast<double>(nodes) * static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+}
+
+// Codegen writes the assembly next to the source file it's given.
+static void BM_Codegen(benchmark::State& state) {
+  std::int64_t functions = 0;
+  const std::string source =
+      BuildSource(static_cast<std::size_t>(state.range(0)), functions);
+  SourceManager source_mgr;
+  FileID file = source_mgr.AddBuffer("bench.c", source);
+  const std::string file_name =
+      (std::filesystem::temp_directory_path() / "jcc_bench.c").string();
+
+  for (auto _ : state) {
+    // Codegen assigns stack offsets to the declarations, so it needs a fresh
+    // AST every time.
+    state.PauseTiming();
+    IdentifierTable idents;
+    Lexer lexer(source_mgr, file, idents);
+    Parser parser(lexer);
+    std::vector<Decl*> decls = parser.ParseTranslateUnit();
+    state.ResumeTiming();
+
+    GenerateAssembly(file_name, decls);
+  }
+  state.SetItemsProcessed(state.iterations() * functions);
+  std::filesystem::remove(
+      std::filesystem::path(file_name).replace_extension(".s"));
+}
+
+// From 1KiB to 100MiB. Parsing keeps the whole AST around, which takes
+// around 30 times the size of the source, so it stops at 16MiB.
+BENCHMARK(BM_Lex)
+    ->Arg(1 << 10)
+    ->Arg(64 << 10)
+    ->Arg(1 << 20)
+    ->Arg(16 << 20)
+    ->Arg(100 << 20)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Parse)
+    ->Arg(1 << 10)
+    ->Arg(64 << 10)
+    ->Arg(1 << 20)
+    ->Arg(16 << 20)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Codegen)
+    ->Arg(1 << 10)
+    ->Arg(64 << 10)
+    ->Arg(1 << 20)
+    ->Arg(16 << 20)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "jcc/keywords.h"
+#include "jcc/token.h"
+
+// The keyword table the lexer used before `Keywords` became a compile-time
+// perfect hash, kept here as the baseline.
+static std::unordered_map<std::string_view, jcc::TokenKind> BuildKeywordMap() {
+  using enum jcc::TokenKind;
+  return {{"alignof", AlignOf},
+          {"auto", Auto},
+          {"break", Break},
+          {"case", Case},
+          {"char", Char},
+          {"const", Const},
+          {"continue", Continue},
+          {"default", Default},
+          {"do", Do},
+          {"double", Double},
+          {"else", Else},
+          {"enum", Enum},
+          {"extern", Extern},
+          {"float", Float},
+          {"for", For},
+          {"goto", Goto},
+          {"if", If},
+          {"inline", Inline},
+          {"int", Int},
+          {"long", Long},
+          {"register", Register},
+          {"restrict", Restrict},
+          {"return", Return},
+          {"short", Short},
+          {"signed", Signed},
+          {"sizeof", Sizeof},
+          {"static", Static},
+          {"struct", Struct},
+          {"switch", Switch},
+          {"typedef", Typedef},
+          {"union", Union},
+          {"unsigned", Unsigned},
+          {"void", Void},
+          {"while", While},
+          {"_Alignas", DashAlignas},
+          {"_Atomic", DashAtmoic},
+          {"_Bool", DashBool},
+          {"_Complex", DashComplex},
+          {"_Generic", DashGeneric},
+          {"_Imaginary", DashImaginary},
+          {"_Noreturn", DashNoReturn},
+          {"_Static_assert", DashStaticAssert},
+          {"_Thread_local", DashThreadLocal}};
+}
+
+// Roughly what the identifier stream of generated C looks like: keywords
+// interleaved with short locals and longer, prefixed function names.
+static const std::vector<std::string_view>& GetIdentifiers() {
+  static const std::vector<std::string_view> identifiers = {
+      "int",      "i",         "for",       "return",    "x",      "static",
+      "void",     "buf",       "len",       "if",        "while",  "char",
+      "unsigned", "long",      "tmp",       "struct",    "node",   "next",
+      "const",    "sizeof",    "gen_fn_42", "gen_var_7", "do_it",  "else",
+      "break",    "case",      "switch",    "default",   "ptr",    "typedef",
+      "_Bool",    "result",    "doubled",   "inline",    "count",  "enum",
+      "extern",   "short",     "signedness", "union"};
+  return identifiers;
+}
+
+static void BM_KeywordMapConstruction(benchmark::State& state) {
+  for (auto _ : state) {
+    auto map = BuildKeywordMap();
+    benchmark::DoNotOptimize(map);
+  }
+}
+BENCHMARK(BM_KeywordMapConstruction);
+
+static void BM_KeywordMapMatch(benchmark::State& state) {
+  const auto map = BuildKeywordMap();
+  const auto& identifiers = GetIdentifiers();
+  for (auto _ : state) {
+    for (std::string_view identifier : identifiers) {
+      std::optional<jcc::TokenKind> kind;
+      if (auto iter = map.find(identifier); iter != map.end()) {
+        kind = iter->second;
+      }
+      benchmark::DoNotOptimize(kind);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(identifiers.size()));
+}
+BENCHMARK(BM_KeywordMapMatch);
+
+static void BM_KeywordPerfectHashMatch(benchmark::State& state) {
+  const auto& identifiers = GetIdentifiers();
+  for (auto _ : state) {
+    for (std::string_view identifier : identifiers) {
+      std::optional<jcc::TokenKind> kind = jcc::Keywords::Match(identifier);
+      benchmark::DoNotOptimize(kind);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(identifiers.size()));
+}
+BENCHMARK(BM_KeywordPerfectHashMatch);
+
+BENCHMARK_MAIN();
@@ -1,110 +1,196 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
-#include <limits>
+#include <new>
 #include <type_traits>
 #include <vector>
 
 namespace jcc {
 
+// A bump pointer allocator. Memory is carved out of chunks which are only
+// given back when the arena is reset or destroyed.
+//
+// Chunks double in size, from min_chunk_size up to max_chunk_size, so a
+// large arena needs few of them. Allocations which would take up more than
+// half a chunk get a dedicated chunk instead, leaving the current one to the
+// allocations after them.
 class Arena {
   static constexpr std::size_t min_chunk_size = 4096;
-  static constexpr std::size_t max_chunk_size =
-      std::numeric_limits<uint16_t>::max();
+  static constexpr std::size_t max_chunk_size = 1024 * 1024;
   static constexpr std::size_t alignment =
       std::alignment_of<std::max_align_t>::value;
 
-  struct Chunk {
-    explicit Chunk(Chunk *ptr) : prev_(ptr) {}
+  // Header in front of the memory of each chunk, padded so the memory right
+  // behind it is aligned.
+  struct alignas(alignment) Chunk {
+    Chunk(Chunk *prev, std::size_t size) : prev_(prev), size_(size) {}
 
-    union {
-      Chunk *prev_ = nullptr;
-      std::byte aligned_[alignment];
-    };
+    Chunk *prev_;
+    // Usable size, excluding the header.
+    std::size_t size_;
   };
 
+  // Regular chunks, newest first. The oldest one is kept across Reset.
   Chunk *current_chunk_ = nullptr;
-  // total size which available to allocate
-  std::size_t available_size_ = 0;
-  // The total chunks size
-  // = allocatedSize_ + availableSize_ + Memory Deprecated (Size can't fit
-  // allocation) Current pointer to available memory address
+  // Dedicated chunks of large allocations, newest first.
+  Chunk *large_chunks_ = nullptr;
+  // The free tail of the current chunk.
   std::byte *current_ptr_ = nullptr;
+  std::size_t available_size_ = 0;
+
+  // Regular chunks allocated so far, which drives their growth.
+  std::size_t num_chunks_ = 0;
+  std::size_t num_large_chunks_ = 0;
+  // Sum of all the sizes passed to AllocateAligned.
+  std::size_t bytes_requested_ = 0;
+  // Bytes skipped to align allocations.
+  std::size_t bytes_padding_ = 0;
 
  public:
   Arena() = default;
   Arena(const Arena &) = delete;
   Arena(Arena &&) = delete;
   ~Arena() {
-    while (current_chunk_ != nullptr) {
-      Chunk *prev = current_chunk_->prev_;
-      delete[] current_chunk_;
-      current_chunk_ = prev;
-    }
-    available_size_ = 0;
-    current_ptr_ = nullptr;
+    FreeChunks(current_chunk_, nullptr);
+    FreeChunks(large_chunks_, nullptr);
   }
 
   // The CPU access memory with the alignment,
   // So construct object from alignment address will reduce the CPU access count
   // then speed up read/write
   void *AllocateAligned(std::size_t alloc) {
+    bytes_requested_ += alloc;
     const std::size_t pad =
-        alignment -
-        (reinterpret_cast<uintptr_t>(current_ptr_) & (alignment - 1));
-    const std::size_t consumption = alloc + pad;
-    if (consumption > max_chunk_size) {
-      return nullptr;
-    }
-    if (consumption <= available_size_) {
+        -reinterpret_cast<uintptr_t>(current_ptr_) & (alignment - 1);
+    if (alloc + pad <= available_size_) {
       void *ptr = current_ptr_ + pad;
-      current_ptr_ += consumption;
-      available_size_ -= consumption;
+      current_ptr_ += alloc + pad;
+      available_size_ -= alloc + pad;
+      bytes_padding_ += pad;
       return ptr;
     }
-    NewChunk(std::max(alloc, min_chunk_size));
-    void *ptr = current_ptr_;
-    current_ptr_ += alloc;
-    available_size_ -= alloc;
-    return ptr;
+
+    const std::size_t chunk_size = NextChunkSize();
+    if (alloc > chunk_size / 2) {
+      large_chunks_ = NewChunk(large_chunks_, alloc);
+      num_large_chunks_++;
+      return large_chunks_ + 1;
+    }
+
+    // New chunks start out aligned.
+    current_chunk_ = NewChunk(current_chunk_, chunk_size);
+    num_chunks_++;
+    current_ptr_ = reinterpret_cast<std::byte *>(current_chunk_ + 1) + alloc;
+    available_size_ = chunk_size - alloc;
+    return current_chunk_ + 1;
+  }
+
+  // Frees everything allocated so far but keeps the first chunk around, so
+  // an arena reused for similar work mostly doesn't go back to the heap.
+  void Reset() {
+    FreeChunks(large_chunks_, nullptr);
+    large_chunks_ = nullptr;
+    num_large_chunks_ = 0;
+    bytes_requested_ = 0;
+    bytes_padding_ = 0;
+    if (current_chunk_ == nullptr) {
+      return;
+    }
+
+    Chunk *first = current_chunk_;
+    while (first->prev_ != nullptr) {
+      first = first->prev_;
+    }
+    FreeChunks(current_chunk_, first);
+    current_chunk_ = first;
+    num_chunks_ = 1;
+    current_ptr_ = reinterpret_cast<std::byte *>(first + 1);
+    available_size_ = first->size_;
   }
 
   [[nodiscard]] std::size_t AvailableSize() const { return available_size_; }
 
+  [[nodiscard]] std::size_t GetBytesRequested() const {
+    return bytes_requested_;
+  }
+
+  [[nodiscard]] std::size_t GetBytesPadding() const { return bytes_padding_; }
+
+  // Regular and large chunks.
+  [[nodiscard]] std::size_t GetNumChunks() const {
+    return num_chunks_ + num_large_chunks_;
+  }
+
  private:
-  // allocate new chunk
-  // The current pointer will keep alignment
-  void NewChunk(std::size_t size) {
+  [[nodiscard]] std::size_t NextChunkSize() const {
+    constexpr std::size_t max_shift = std::countr_zero(max_chunk_size) -
+                                      std::countr_zero(min_chunk_size);
+    return min_chunk_size << std::min(num_chunks_, max_shift);
+  }
+
+  static Chunk *NewChunk(Chunk *prev, std::size_t size) {
     assert(size != 0 && "Can't allocate 0 size chunk!");
-    auto *ptr = new std::byte[size + sizeof(Chunk)];
-    current_chunk_ = new (ptr) Chunk(current_chunk_);
-    available_size_ = size;
-    current_ptr_ = (ptr + sizeof(Chunk));
+    auto *ptr = new std::byte[sizeof(Chunk) + size];
+    return new (ptr) Chunk(prev, size);
+  }
+
+  // Frees the chunks from `chunk` up to but excluding `last`.
+  static void FreeChunks(Chunk *chunk, Chunk *last) {
+    while (chunk != last) {
+      Chunk *prev = chunk->prev_;
+      delete[] reinterpret_cast<std::byte *>(chunk);
+      chunk = prev;
+    }
   }
 };
 
+// Allocates objects derived from T in an arena. Memory is only given back
+// as a whole, so the allocator runs the destructors of the objects which
+// need one when it goes away. Trivially destructible objects cost nothing
+// but their bytes.
 template <typename T>
 class Allocator {
-  std::vector<void *> slabs_;
+  struct Destructor {
+    void *object;
+    void (*destroy)(void *);
+  };
+
+  std::vector<Destructor> destructors_;
   Arena arena_;
+  std::size_t num_objects_ = 0;
 
  public:
+  Allocator() = default;
+  Allocator(const Allocator &) = delete;
+  Allocator &operator=(const Allocator &) = delete;
+
   template <typename U>
   requires std::is_base_of_v<T, U>
   void *Allocate() {
     void *mem = arena_.AllocateAligned(sizeof(U));
-    slabs_.push_back(mem);
+    num_objects_++;
+    if constexpr (!std::is_trivially_destructible_v<U>) {
+      destructors_.push_back(
+          {mem, [](void *object) { static_cast<U *>(object)->~U(); }});
+    }
     return mem;
   }
 
-  static void Deallocate(void *mem) { reinterpret_cast<T *>(mem)->~T(); }
+  // Memory for something which isn't a T, like the children of a node. No
+  // destructor is run for it.
+  void *AllocateRaw(std::size_t size) { return arena_.AllocateAligned(size); }
+
+  [[nodiscard]] std::size_t GetNumObjects() const { return num_objects_; }
 
   ~Allocator() {
-    for (auto *slab : slabs_) {
-      Deallocate(slab);
+    for (auto iter = destructors_.rbegin(); iter != destructors_.rend();
+         ++iter) {
+      iter->destroy(iter->object);
     }
   }
 };
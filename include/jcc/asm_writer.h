@@ -0,0 +1,183 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace jcc {
+
+class Assembler;
+
+// Assembly text, formatted straight into a list of chunks. Text already
+// written never moves, unlike appending to a std::string, which copies all
+// of it every time it grows.
+class AsmBuffer {
+  static constexpr std::size_t chunk_size = 64 * 1024;
+
+  struct Chunk {
+    std::unique_ptr<char[]> data;
+    std::size_t capacity;
+    // The bytes written, only up to date once the chunk isn't the last.
+    std::size_t size;
+  };
+
+  std::vector<Chunk> chunks_;
+  // The free tail of the last chunk.
+  char* cur_ = nullptr;
+  char* end_ = nullptr;
+
+ public:
+  AsmBuffer() = default;
+  AsmBuffer(const AsmBuffer&) = delete;
+  AsmBuffer& operator=(const AsmBuffer&) = delete;
+
+  void Append(std::string_view text) {
+    if (static_cast<std::size_t>(end_ - cur_) < text.size()) {
+      NewChunk(text.size());
+    }
+    cur_ = std::copy(text.begin(), text.end(), cur_);
+  }
+
+  void Append(char c) {
+    if (cur_ == end_) {
+      NewChunk(1);
+    }
+    *cur_++ = c;
+  }
+
+  void VFormat(fmt::string_view format, fmt::format_args args);
+
+  [[nodiscard]] std::size_t GetSize() const;
+
+  // Writes everything to `fd` and empties the buffer, keeping the first
+  // chunk for what comes next. Returns false if writing failed.
+  bool Drain(int fd);
+
+  // Like Drain(), but passes the chunks to `sink` instead, which returns
+  // false on failure.
+  template <typename Sink>
+  bool Drain(Sink sink) {
+    for (const Chunk& chunk : chunks_) {
+      if (!sink(std::string_view(chunk.data.get(), GetChunkSize(chunk)))) {
+        return false;
+      }
+    }
+    Clear();
+    return true;
+  }
+
+ private:
+  // Starts a chunk with room for at least `size` bytes.
+  void NewChunk(std::size_t size);
+
+  // Empties the buffer, all but the first chunk are freed.
+  void Clear();
+
+  [[nodiscard]] std::size_t GetChunkSize(const Chunk& chunk) const {
+    return &chunk == &chunks_.back() ? cur_ - chunk.data.get() : chunk.size;
+  }
+};
+
+// Writes an assembly file one line at a time. Format strings are checked at
+// compile time and formatted in place, no temporary strings involved.
+//
+// The text is streamed to the file whenever Flush() finds enough of it, so
+// it needn't be held in memory all at once. The data section comes after
+// it, as data is emitted in the middle of functions: it's buffered, spilled
+// to an unnamed temporary file once it grows large, and copied to the end
+// of the output by Finish().
+//
+// Given an Assembler, the text is passed to it as it's flushed instead, and
+// Finish() leaves the object to be taken from the assembler.
+class AsmWriter {
+ public:
+  enum class Section { Header, Data, Text };
+
+ private:
+  // Data beyond this much goes to the spill file.
+  static constexpr std::size_t max_buffered_data = 1024 * 1024;
+
+  int fd_;
+  Assembler* assembler_ = nullptr;
+  // Where to create the spill file, next to the output so copying it over
+  // can stay within the file system.
+  std::string spill_dir_;
+  int spill_fd_ = -1;
+  std::size_t spilled_ = 0;
+
+  AsmBuffer header_;
+  AsmBuffer data_;
+  AsmBuffer text_;
+  AsmBuffer* cur_ = &text_;
+
+ public:
+  // Writes to `fd`, which stays owned by the caller.
+  AsmWriter(int fd, std::string spill_dir)
+      : fd_(fd), spill_dir_(std::move(spill_dir)) {}
+  // Has `assembler` assemble the text, nothing is written.
+  explicit AsmWriter(Assembler& assembler) : fd_(-1), assembler_(&assembler) {}
+  AsmWriter(const AsmWriter&) = delete;
+  AsmWriter& operator=(const AsmWriter&) = delete;
+  ~AsmWriter();
+
+  // Subsequent lines go to `section`.
+  void SetSection(Section section) {
+    switch (section) {
+      case Section::Header:
+        cur_ = &header_;
+        break;
+      case Section::Data:
+        cur_ = &data_;
+        break;
+      case Section::Text:
+        cur_ = &text_;
+        break;
+    }
+  }
+
+  // An indented instruction, like `mov %rax, %rdi`.
+  template <typename... Args>
+  void Instr(fmt::format_string<Args...> format, Args&&... args) {
+    Line("  ", format, fmt::make_format_args(args...));
+  }
+
+  // An indented directive, like `.globl main`.
+  template <typename... Args>
+  void Directive(fmt::format_string<Args...> format, Args&&... args) {
+    Line("  ", format, fmt::make_format_args(args...));
+  }
+
+  // A label definition, the colon is added.
+  template <typename... Args>
+  void Label(fmt::format_string<Args...> format, Args&&... args) {
+    cur_->VFormat(format, fmt::make_format_args(args...));
+    cur_->Append(":\n");
+  }
+
+  // Writes out the text and spills the data once enough of them built up,
+  // so it's cheap to call after every function.
+  void Flush();
+
+  // Writes out everything left, the data last.
+  void Finish();
+
+ private:
+  void Line(std::string_view indent, fmt::string_view format,
+            fmt::format_args args) {
+    cur_->Append(indent);
+    cur_->VFormat(format, args);
+    cur_->Append('\n');
+  }
+
+  void WriteText();
+  void SpillData();
+  // Passes all the text buffered to the assembler.
+  void AssembleText();
+};
+}  // namespace jcc
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "jcc/elf_writer.h"
+
+namespace jcc {
+
+struct Operand;
+
+// Encodes the AT&T assembly CodeGen writes into x86-64 machine code, in
+// process, so an object file takes neither a detour through the file system
+// nor a run of `as`.
+//
+// It knows the instructions and directives CodeGen uses and the forms they
+// take, not the whole language. Anything else is a bug in CodeGen and
+// aborts.
+class Assembler {
+  enum SectionIndex { Text, Data, NumSections };
+
+  using Opcode = std::initializer_list<std::uint8_t>;
+
+  struct Symbol {
+    std::string name;
+    // Where it's defined, NumSections if it isn't.
+    SectionIndex section = NumSections;
+    std::uint64_t value = 0;
+    std::uint64_t size = 0;
+    bool global = false;
+    unsigned char type = 0;
+    // Its index in ObjectFile::symbols, if it made it there.
+    std::size_t object_index = 0;
+  };
+
+  // A reference to a symbol not resolved until all of them are defined.
+  struct Fixup {
+    SectionIndex section;
+    std::uint64_t offset;
+    std::size_t symbol;
+    std::int64_t addend;
+    std::uint32_t type;
+  };
+
+  std::string file_name_;
+  std::string sections_[NumSections];
+  std::uint64_t alignments_[NumSections] = {1, 1};
+  SectionIndex cur_ = Text;
+
+  // A deque, as the table refers to the names.
+  std::deque<Symbol> symbols_;
+  std::unordered_map<std::string_view, std::size_t> symbol_table_;
+  std::vector<Fixup> fixups_;
+
+  // The end of the text of the last call, if it stopped mid-line.
+  std::string partial_line_;
+  // The line being assembled, for error messages.
+  std::string_view line_;
+
+ public:
+  Assembler() = default;
+  Assembler(const Assembler&) = delete;
+  Assembler& operator=(const Assembler&) = delete;
+
+  // Assembles `text`, which needn't end at the end of a line.
+  void Assemble(std::string_view text);
+
+  // Resolves the references within the sections and turns the rest into
+  // relocations.
+  ObjectFile Finish();
+
+ private:
+  void AssembleLine(std::string_view line);
+  void AssembleDirective(std::string_view name, std::string_view args);
+  void AssembleInstr(std::string_view mnemonic, std::string_view operands);
+
+  [[noreturn]] void Error(std::string_view what) const;
+
+  std::size_t GetSymbol(std::string_view name);
+  void DefineLabel(std::string_view name);
+
+  std::string& Out() { return sections_[cur_]; }
+  void Emit(std::uint8_t byte) { Out().push_back(static_cast<char>(byte)); }
+  void EmitImm(std::int64_t value, int size);
+
+  // Emits the operand size prefix, a REX prefix if any is needed, then
+  // `opcode`, then a ModRM byte with `reg` in its reg field addressing
+  // `rm`, then `imm_size` bytes of `imm`. `size` is the operand size in
+  // bytes.
+  void EmitModRM(Opcode opcode, int size, const Operand& reg, const Operand& rm,
+                 std::int64_t imm = 0, int imm_size = 0);
+  // Emits an opcode with the register `reg` added to its last byte.
+  void EmitPlusReg(Opcode opcode, int size, const Operand& reg);
+  // Emits `opcode` followed by a 32-bit displacement to `target`.
+  void EmitBranch(Opcode opcode, const Operand& target, std::uint32_t type);
+  // Emits a 32-bit field to be filled in with the address of `symbol`.
+  void EmitFixup(std::string_view symbol, std::int64_t addend,
+                 std::uint32_t type);
+};
+}  // namespace jcc
@@ -1,39 +1,72 @@
 #pragma once
 
-#include <iterator>
-#include <map>
-#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <span>
 #include <type_traits>
-#include <vector>
+#include <unordered_map>
 
 #include "jcc/allocator.h"
 #include "jcc/ast_node.h"
 #include "jcc/common.h"
+#include "jcc/identifier_table.h"
+#include "jcc/scoped_table.h"
 
 namespace jcc {
 
 class Decl;
 class FunctionDecl;
 class Type;
-
-struct Scope {
-  void PushVar(const std::string& name, Decl* var) { vars[name] = var; }
-  void PushType(const std::string& name, Type* tag) { types[name] = tag; }
-
-  std::map<std::string, Decl*> vars;
-  std::map<std::string, Type*> types;
-};
+enum class Qualifiers : std::uint8_t;
 
 class ASTContext {
-  std::vector<Scope> scopes_;
+  // Everything that makes a derived type unique.
+  struct TypeKey {
+    enum class Derivation : std::uint8_t {
+      Pointer,
+      Array,
+      Function,
+      Qualified,
+    };
+
+    Derivation derivation;
+    // The pointee, the element type, the return type or the unqualified type.
+    const Type* base;
+    // The length of arrays, the qualifiers and storage of qualified types.
+    std::uint64_t extra = 0;
+    // The parameters of function types. Keys in derived_types_ refer to the
+    // copy owned by the FunctionType.
+    std::span<Type* const> params;
+
+    bool operator==(const TypeKey& other) const;
+
+    struct Hash {
+      std::size_t operator()(const TypeKey& key) const;
+    };
+  };
+
+  // Declarations and types are looked up separately.
+  ScopedTable<Decl> vars_;
+  ScopedTable<Type> types_;
+
+  IdentifierTable& idents_;
 
   Allocator<ASTNode> ast_node_allocator_;
   Allocator<Type> type_allocator_;
 
-  FunctionDecl* cur_func_ = nullptr;
+  // Derived types are hash-consed, so structurally equal types are the same
+  // object.
+  std::unordered_map<TypeKey, Type*, TypeKey::Hash> derived_types_;
 
  public:
-  ASTContext() = default;
+  explicit ASTContext(IdentifierTable& idents);
+
+  IdentifierTable& GetIdentifierTable() { return idents_; }
+
+  // The number of AST nodes created so far.
+  [[nodiscard]] std::size_t GetNumNodes() const {
+    return ast_node_allocator_.GetNumObjects();
+  }
 
   template <typename T>
   void* Allocate() {
@@ -45,6 +78,27 @@ class ASTContext {
     jcc_unreachable("Can't allocate for unknown type!");
   }
 
+  // Uninitialized memory for `size` Ts, which live as long as the context
+  // but are never destroyed.
+  template <typename T>
+  std::span<T> AllocateArray(std::size_t size) {
+    static_assert(std::is_trivially_destructible_v<T>);
+    if (size == 0) {
+      return {};
+    }
+    void* mem = ast_node_allocator_.AllocateRaw(size * sizeof(T));
+    return {static_cast<T*>(mem), size};
+  }
+
+  // Copies `elems` into the context, which is where nodes keep their lists
+  // of children. Those are usually built in a SmallVector first.
+  template <typename T>
+  std::span<T> CopyArray(std::span<const T> elems) {
+    std::span<T> copy = AllocateArray<T>(elems.size());
+    std::copy(elems.begin(), elems.end(), copy.begin());
+    return copy;
+  }
+
   Type* GetVoidType();
   Type* GetBoolType();
   Type* GetCharType();
@@ -59,36 +113,35 @@ class ASTContext {
   Type* GetDoubleType();
   Type* GetLDoubleType();
 
-  void EnterScope() { scopes_.emplace_back(); }
-  void ExitScope() { scopes_.pop_back(); }
+  Type* GetPointerType(Type* base);
+  Type* GetArrayType(Type* base, std::size_t len);
+  Type* GetFunctionType(Type* return_type, std::span<Type* const> params);
+  // A builtin type with qualifiers or static storage attached.
+  Type* GetQualifiedType(Type* base, Qualifiers quals, bool is_static);
 
-  Scope& GetCurScope() { return scopes_.back(); }
-
-  // Returns current function we are parseing.
-  FunctionDecl* GetCurFunc() { return cur_func_; }
+  void EnterScope() {
+    vars_.EnterScope();
+    types_.EnterScope();
+  }
+  void ExitScope() {
+    vars_.ExitScope();
+    types_.ExitScope();
+  }
 
-  void SetCurFunc(FunctionDecl* func) { cur_func_ = func; }
+  void PushVar(const IdentifierInfo* name, Decl* var) {
+    vars_.Insert(name, var);
+  }
+  void PushType(IdentifierInfo* name, Type* type) {
+    name->SetMaybeTypeName();
+    types_.Insert(name, type);
+  }
 
-  [[nodiscard]] Decl* Lookup(const std::string& name) const {
-    for (auto rbeg = scopes_.rbegin(), rend = scopes_.rend(); rbeg != rend;
-         rbeg++) {
-      auto iter = rbeg->vars.find(name);
-      if (iter != rbeg->vars.end()) {
-        return iter->second;
-      }
-    }
-    return nullptr;
+  [[nodiscard]] Decl* Lookup(const IdentifierInfo* name) const {
+    return vars_.Lookup(name);
   }
 
-  [[nodiscard]] Type* LookupType(const std::string& name) const {
-    for (auto rbeg = scopes_.rbegin(), rend = scopes_.rend(); rbeg != rend;
-         rbeg++) {
-      auto iter = rbeg->types.find(name);
-      if (iter != rbeg->types.end()) {
-        return iter->second;
-      }
-    }
-    return nullptr;
+  [[nodiscard]] Type* LookupType(const IdentifierInfo* name) const {
+    return types_.Lookup(name);
   }
 };
 }  // namespace jcc
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "jcc/ast_visitor.h"
+
+namespace jcc {
+
+// Prints the AST as an indented tree, one node per line, for --ast-dump.
+class ASTDumper : public ASTVisitor<ASTDumper> {
+  int indent_ = 0;
+
+  void InsertIndent() const;
+
+  // Dumps `node` one level deeper than the node being dumped.
+  void DumpChild(ASTNode* node);
+
+ public:
+  void VisitVarDecl(VarDecl& decl);
+  void VisitFunctionDecl(FunctionDecl& decl);
+  void VisitRecordDecl(RecordDecl& decl);
+
+  void VisitCompoundStatement(CompoundStatement& stmt);
+  void VisitIfStatement(IfStatement& stmt);
+  void VisitCaseStatement(CaseStatement& stmt);
+  void VisitSwitchStatement(SwitchStatement& stmt);
+  void VisitWhileStatement(WhileStatement& stmt);
+  void VisitDoStatement(DoStatement& stmt);
+  void VisitForStatement(ForStatement& stmt);
+  void VisitContinueStatement(ContinueStatement& stmt);
+  void VisitBreakStatement(BreakStatement& stmt);
+  void VisitReturnStatement(ReturnStatement& stmt);
+  void VisitDeclStatement(DeclStatement& stmt);
+  void VisitExprStatement(ExprStatement& stmt);
+
+  void VisitStringLiteral(StringLiteral& expr);
+  void VisitCharacterLiteral(CharacterLiteral& expr);
+  void VisitIntergerLiteral(IntergerLiteral& expr);
+  void VisitFloatingLiteral(FloatingLiteral& expr);
+  void VisitCallExpr(CallExpr& expr);
+  void VisitUnaryExpr(UnaryExpr& expr);
+  void VisitBinaryExpr(BinaryExpr& expr);
+  void VisitDeclRefExpr(DeclRefExpr& expr);
+
+  // Nodes without a dumper of their own, like MemberExpr, only get their
+  // kind printed.
+  void VisitASTNode(ASTNode& node);
+};
+}  // namespace jcc
@@ -1,25 +1,35 @@
 #pragma once
 
+#include <cstdint>
+
 #include "jcc/source_location.h"
 
 namespace jcc {
 
-class CodeGen;
+// The dynamic kind of an ASTNode, which `isa`, `cast` and `dyn_cast` use
+// instead of RTTI. Every abstract node class owns a contiguous range of kinds,
+// delimited by its First* and Last* markers.
+enum class ASTNodeKind : std::uint8_t {
+#define DECL(Name) Name,
+#define STMT(Name) Name,
+#include "jcc/ast_nodes.def"
+
+  FirstDecl = VarDecl,
+  LastDecl = RecordDecl,
+  FirstStmt = LabeledStatement,
+  LastStmt = DeclRefExpr,
+  FirstExpr = StringLiteral,
+  LastExpr = DeclRefExpr,
+};
 
 class ASTNode {
+  ASTNodeKind kind_;
   SourceRange loc_;
 
  protected:
-  explicit ASTNode(SourceRange loc) : loc_(std::move(loc)) {}
+  ASTNode(ASTNodeKind kind, SourceRange loc) : kind_(kind), loc_(loc) {}
 
  public:
-  virtual ~ASTNode();
-  virtual void dump(int indent) const = 0;
-  virtual void GenCode(CodeGen& gen) = 0;
-
-  template <typename Ty>
-  Ty* As() {
-    return dynamic_cast<Ty*>(this);
-  }
+  [[nodiscard]] ASTNodeKind GetKind() const { return kind_; }
 };
 }  // namespace jcc
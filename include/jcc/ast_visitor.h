@@ -0,0 +1,47 @@
+#pragma once
+
+#include "jcc/ast_node.h"
+#include "jcc/common.h"
+#include "jcc/decl.h"
+#include "jcc/expr.h"
+#include "jcc/stmt.h"
+
+namespace jcc {
+
+// A CRTP visitor over the AST. `Visit` switches on the kind of the node and
+// calls `Derived::Visit<Node>` directly, so a pass pays for one jump per node
+// and the compiler is free to inline its handlers.
+//
+// Handlers a pass doesn't provide fall back to the one of the parent class,
+// e.g. `VisitBinaryExpr` to `VisitExpr`, then `VisitStmt` and finally
+// `VisitASTNode`, which does nothing.
+template <typename Derived, typename RetTy = void>
+class ASTVisitor {
+  Derived& GetDerived() { return *static_cast<Derived*>(this); }
+
+ public:
+  RetTy Visit(ASTNode* node) {
+    switch (node->GetKind()) {
+#define DECL(Name)        \
+  case ASTNodeKind::Name: \
+    return GetDerived().Visit##Name(*static_cast<Name*>(node));
+#define STMT(Name) DECL(Name)
+#include "jcc/ast_nodes.def"
+    }
+    jcc_unreachable("Unknown AST node kind!");
+  }
+
+#define DECL(Name) \
+  RetTy Visit##Name(Name& decl) { return GetDerived().VisitDecl(decl); }
+#define STMT(Name) \
+  RetTy Visit##Name(Name& stmt) { return GetDerived().VisitStmt(stmt); }
+#define EXPR(Name) \
+  RetTy Visit##Name(Name& expr) { return GetDerived().VisitExpr(expr); }
+#include "jcc/ast_nodes.def"
+
+  RetTy VisitDecl(Decl& decl) { return GetDerived().VisitASTNode(decl); }
+  RetTy VisitExpr(Expr& expr) { return GetDerived().VisitStmt(expr); }
+  RetTy VisitStmt(Stmt& stmt) { return GetDerived().VisitASTNode(stmt); }
+  RetTy VisitASTNode(ASTNode&) { return RetTy(); }
+};
+}  // namespace jcc
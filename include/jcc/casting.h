@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cassert>
+
+namespace jcc {
+
+// LLVM style casting over hierarchies which carry their own kind tag. The
+// target class provides `static bool classof(const Base*)`, so none of these
+// need RTTI and a check is a single compare (or a range check for abstract
+// classes) on the kind.
+
+template <typename To, typename From>
+[[nodiscard]] bool isa(const From* node) {
+  assert(node != nullptr && "isa<> used on a null pointer");
+  return To::classof(node);
+}
+
+template <typename To, typename From>
+To* cast(From* node) {
+  assert(isa<To>(node) && "cast<Ty>() argument of incompatible type!");
+  return static_cast<To*>(node);
+}
+
+template <typename To, typename From>
+const To* cast(const From* node) {
+  assert(isa<To>(node) && "cast<Ty>() argument of incompatible type!");
+  return static_cast<const To*>(node);
+}
+
+template <typename To, typename From>
+To* dyn_cast(From* node) {
+  return isa<To>(node) ? static_cast<To*>(node) : nullptr;
+}
+
+template <typename To, typename From>
+const To* dyn_cast(const From* node) {
+  return isa<To>(node) ? static_cast<const To*>(node) : nullptr;
+}
+}  // namespace jcc
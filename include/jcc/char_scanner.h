@@ -0,0 +1,56 @@
+#pragma once
+
+namespace jcc {
+
+// Finds the end of runs of characters belonging to one class, 16 or 32 bytes
+// at a time where the CPU supports it. Which implementation is used is picked
+// once at runtime.
+//
+// All scanners require the buffer to be NUL terminated: NUL never belongs to
+// any class, so it always ends a run. The vectorized implementations may read
+// past the terminator, but never across the aligned block containing it, so
+// they can't fault.
+class CharScanner {
+ public:
+  enum class Kind { Scalar, SSE2, AVX2 };
+
+  using ScanFn = const char* (*)(const char*);
+
+  constexpr CharScanner(Kind kind, ScanFn whitespace, ScanFn identifier,
+                        ScanFn digits, ScanFn comment)
+      : kind_(kind),
+        whitespace_(whitespace),
+        identifier_(identifier),
+        digits_(digits),
+        comment_(comment) {}
+
+  // Returns the fastest scanner the running CPU supports.
+  static const CharScanner& Get();
+
+  // Returns the scanner of the given kind, or nullptr if the running CPU
+  // doesn't support it.
+  static const CharScanner* Get(Kind kind);
+
+  [[nodiscard]] Kind GetKind() const { return kind_; }
+
+  // Skips ' ', '\t', '\n', '\v', '\f' and '\r'.
+  const char* SkipWhitespace(const char* ptr) const { return whitespace_(ptr); }
+
+  // Skips [A-Za-z_].
+  const char* SkipIdentifier(const char* ptr) const { return identifier_(ptr); }
+
+  // Skips [0-9.].
+  const char* SkipDigits(const char* ptr) const { return digits_(ptr); }
+
+  // Returns the position of the `*/` closing a block comment, or the NUL
+  // terminator if the comment is unterminated.
+  const char* FindCommentEnd(const char* ptr) const { return comment_(ptr); }
+
+ private:
+  Kind kind_;
+  ScanFn whitespace_;
+  ScanFn identifier_;
+  ScanFn digits_;
+  ScanFn comment_;
+};
+}  // namespace jcc
@@ -1,7 +1,5 @@
 #pragma once
 
-#include <fmt/format.h>
-
 #include <cassert>
 #include <cstddef>
 #include <cstdlib>
@@ -9,12 +7,16 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
-#include "fmt/core.h"
+#include "jcc/asm_writer.h"
+#include "jcc/ast_visitor.h"
+#include "jcc/elf_writer.h"
 #include "jcc/stmt.h"
 
 namespace jcc {
 
+class Assembler;
 class Type;
 
 class VarDecl;
@@ -49,6 +51,21 @@ struct CodeGenContext {
 void GenerateAssembly(const std::string& file_name,
                       const std::vector<jcc::Decl*>& decls);
 
+// Like GenerateAssembly, but assembles the code in process and writes a
+// relocatable object to `object_name`.
+void GenerateObject(const std::string& file_name,
+                    const std::string& object_name,
+                    const std::vector<jcc::Decl*>& decls);
+
+// Like GenerateAssembly, but writes to `fd`, a pipe say, which stays owned by
+// the caller.
+void GenerateAssembly(const std::string& file_name, int fd,
+                      const std::vector<jcc::Decl*>& decls);
+
+// Like GenerateObject, but leaves the object in memory.
+ObjectFile GenerateObjectInMemory(const std::string& file_name,
+                                  const std::vector<jcc::Decl*>& decls);
+
 class StackDepthTracker {
  public:
   static int& Get() {
@@ -65,75 +82,66 @@ class StackDepthTracker {
   }
 };
 
-#define EMITDECL(Node) void Emit##Node(Node& decl);
-#define EMITSTMT(Node) void Emit##Node(Node& stmt);
-#define EMITEXPR(Node) void Emit##Node(Node& expr);
+#define VISITDECL(Node) void Visit##Node(Node& decl);
+#define VISITSTMT(Node) void Visit##Node(Node& stmt);
+#define VISITEXPR(Node) void Visit##Node(Node& expr);
 
-class CodeGen {
+class CodeGen : public ASTVisitor<CodeGen> {
   friend class EmitDataSectionRAII;
 
  public:
-  enum class Section { Header, Data, Text };
+  using Section = AsmWriter::Section;
 
+  // Writes assembly to a .s file next to `file_name`.
   explicit CodeGen(const std::string& file_name);
 
-  ~CodeGen();
+  // Writes assembly to `fd`, which stays owned by the caller.
+  CodeGen(const std::string& file_name, int fd);
 
-  EMITDECL(VarDecl)
-  EMITDECL(FunctionDecl)
-  EMITDECL(RecordDecl)
-
-  EMITSTMT(IfStatement)
-  EMITSTMT(WhileStatement)
-  EMITSTMT(DoStatement)
-  EMITSTMT(ForStatement)
-  EMITSTMT(SwitchStatement)
-  EMITSTMT(CaseStatement)
-  EMITSTMT(ReturnStatement)
-  EMITSTMT(BreakStatement)
-  EMITSTMT(ContinueStatement)
-  EMITSTMT(DeclStatement)
-  EMITSTMT(ExprStatement)
-  EMITSTMT(CompoundStatement)
-
-  EMITEXPR(StringLiteral);
-  EMITEXPR(CharacterLiteral);
-  EMITEXPR(IntergerLiteral);
-  EMITEXPR(FloatingLiteral);
-  EMITEXPR(CallExpr);
-  EMITEXPR(UnaryExpr);
-  EMITEXPR(BinaryExpr);
-  EMITEXPR(ArraySubscriptExpr);
-  EMITEXPR(MemberExpr);
-  EMITEXPR(DeclRefExpr);
+  // Has `assembler` assemble the code instead.
+  CodeGen(const std::string& file_name, Assembler& assembler);
 
- private:
-  template <typename S, typename... Args>
-  void Write(const S& format, Args&&... args) {
-    if (IsDataSection()) {
-      data_ += fmt::format(fmt::runtime(format), std::forward<Args>(args)...);
-      return;
-    }
-    if (IsHeaderSection()) {
-      header_ += fmt::format(fmt::runtime(format), std::forward<Args>(args)...);
-      return;
-    }
-    assert(cur_section_ == Section::Text);
-    text_ += fmt::format(fmt::runtime(format), std::forward<Args>(args)...);
-  }
+  ~CodeGen();
 
-  template <typename S, typename... Args>
-  void Writeln(const S& format, Args&&... args) {
-    Write(format, std::forward<Args>(args)...);
-    Write("\n");
-  }
+  // Streams out the code of the declarations visited so far, if there's
+  // enough of it.
+  void Flush() { out_.Flush(); }
+
+  VISITDECL(VarDecl)
+  VISITDECL(FunctionDecl)
+  VISITDECL(RecordDecl)
+
+  VISITSTMT(IfStatement)
+  VISITSTMT(WhileStatement)
+  VISITSTMT(DoStatement)
+  VISITSTMT(ForStatement)
+  VISITSTMT(SwitchStatement)
+  VISITSTMT(CaseStatement)
+  VISITSTMT(ReturnStatement)
+  VISITSTMT(BreakStatement)
+  VISITSTMT(ContinueStatement)
+  VISITSTMT(DeclStatement)
+  VISITSTMT(ExprStatement)
+  VISITSTMT(CompoundStatement)
+
+  VISITEXPR(StringLiteral);
+  VISITEXPR(CharacterLiteral);
+  VISITEXPR(IntergerLiteral);
+  VISITEXPR(FloatingLiteral);
+  VISITEXPR(CallExpr);
+  VISITEXPR(UnaryExpr);
+  VISITEXPR(BinaryExpr);
+  VISITEXPR(ArraySubscriptExpr);
+  VISITEXPR(MemberExpr);
+  VISITEXPR(DeclRefExpr);
 
+ private:
   void Push() {
-    Writeln("  push %rax");
+    out_.Instr("push %rax");
     StackDepthTracker::Push();
   }
   void Pop(std::string_view arg) {
-    Writeln("  pop {}", arg);
+    out_.Instr("pop {}", arg);
     StackDepthTracker::Pop();
   }
 
@@ -164,26 +172,18 @@ class CodeGen {
 
   void CompZero(const Type& type);
 
-  [[nodiscard]] bool IsDataSection() const {
-    return cur_section_ == Section::Data;
-  }
-
-  [[nodiscard]] bool IsHeaderSection() const {
-    return cur_section_ == Section::Header;
-  }
-
   class EmitFunctionRAII {
     CodeGen& gen_;
 
    public:
     explicit EmitFunctionRAII(CodeGen& gen) : gen_(gen) {
-      gen_.Writeln("  push %rbp");
-      gen_.Writeln("  mov %rsp, %rbp");
+      gen_.out_.Instr("push %rbp");
+      gen_.out_.Instr("mov %rsp, %rbp");
     }
     ~EmitFunctionRAII() {
-      gen_.Writeln("  mov %rbp, %rsp");
-      gen_.Writeln("  pop %rbp");
-      gen_.Writeln("  ret");
+      gen_.out_.Instr("mov %rbp, %rsp");
+      gen_.out_.Instr("pop %rbp");
+      gen_.out_.Instr("ret");
     }
   };
 
@@ -192,23 +192,16 @@ class CodeGen {
 
    public:
     explicit EmitSectionRAII(CodeGen& gen, Section section) : gen_(gen) {
-      gen_.cur_section_ = section;
+      gen_.out_.SetSection(section);
     }
-    ~EmitSectionRAII() { gen_.cur_section_ = Section::Text; }
+    ~EmitSectionRAII() { gen_.out_.SetSection(Section::Text); }
   };
 
   std::string name_;
-
-  // Text section.
-  std::string text_;
-  // Data section.
-  std::string data_;
-
-  // This is only used for program header annotation.
-  std::string header_;
+  // The assembly file it opened, -1 if it writes elsewhere.
+  int fd_;
+  AsmWriter out_;
 
   CodeGenContext ctx;
-
-  Section cur_section_ = Section::Text;
 };
 }  // namespace jcc
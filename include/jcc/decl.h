@@ -2,9 +2,9 @@
 
 #include <cassert>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
-#include <vector>
 
 #include "jcc/ast_node.h"
 
@@ -13,18 +13,27 @@ class Type;
 class Stmt;
 class Expr;
 class ASTContext;
+class IdentifierInfo;
 
 class Decl : public ASTNode {
-  std::string name_;
+  IdentifierInfo* name_;
   Type* type_ = nullptr;
   std::optional<int> offset_;
 
  protected:
-  explicit Decl(SourceRange loc, std::string name, Type* type)
-      : ASTNode(std::move(loc)), name_(std::move(name)), type_(type) {}
+  Decl(ASTNodeKind kind, SourceRange loc, IdentifierInfo* name, Type* type)
+      : ASTNode(kind, loc), name_(name), type_(type) {}
 
  public:
-  [[nodiscard]] std::string GetName() const { return name_; }
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() >= ASTNodeKind::FirstDecl &&
+           node->GetKind() <= ASTNodeKind::LastDecl;
+  }
+
+  // Unnamed declarations, like unnamed parameters, have no IdentifierInfo.
+  [[nodiscard]] IdentifierInfo* GetIdentifier() const { return name_; }
+
+  [[nodiscard]] std::string_view GetName() const;
 
   Type* GetType() {
     assert(type_ != nullptr);
@@ -33,65 +42,67 @@ class Decl : public ASTNode {
 
   void SetOffset(int offset) { offset_ = offset; }
   [[nodiscard]] std::optional<int> GetOffset() const { return offset_; }
-
-  ~Decl() override;
 };
 
 class VarDecl : public Decl {
   Expr* init_ = nullptr;
 
-  VarDecl(SourceRange loc, Expr* init, Type* type, std::string name)
-      : Decl(std::move(loc), std::move(name), type), init_(init) {}
+  VarDecl(SourceRange loc, Expr* init, Type* type, IdentifierInfo* name)
+      : Decl(ASTNodeKind::VarDecl, loc, name, type), init_(init) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::VarDecl;
+  }
+
   static VarDecl* Create(ASTContext& ctx, SourceRange loc, Expr* init,
-                         Type* type, std::string name);
+                         Type* type, IdentifierInfo* name);
 
   Expr* GetInit() { return init_; }
 
   void SetInit(Expr* init) { init_ = init; }
 
   [[nodiscard]] bool IsDefinition() const { return init_ == nullptr; }
-
-  void dump(int indent) const override;
-  void GenCode(CodeGen& gen) override;
 };
 
 class FunctionDecl : public Decl {
-  std::vector<VarDecl*> args_;
+  std::span<VarDecl*> args_;
   Type* return_type_;
   Stmt* body_ = nullptr;
 
   // This makes it much easier to assign offsets for them.
-  std::vector<Decl*> locals_;
+  std::span<Decl*> locals_;
 
   int stack_size_ = -1;
 
-  FunctionDecl(SourceRange loc, std::string name, Type* type, Type* return_type)
-      : Decl(std::move(loc), std::move(name), type),
+  FunctionDecl(SourceRange loc, IdentifierInfo* name, Type* type,
+               Type* return_type)
+      : Decl(ASTNodeKind::FunctionDecl, loc, name, type),
         return_type_(return_type) {}
 
-  FunctionDecl(SourceRange loc, std::string name, std::vector<VarDecl*> args,
+  FunctionDecl(SourceRange loc, IdentifierInfo* name, std::span<VarDecl*> args,
                Type* type, Type* return_type, Stmt* body)
-      : Decl(std::move(loc), std::move(name), type),
-        args_(std::move(args)),
+      : Decl(ASTNodeKind::FunctionDecl, loc, name, type),
+        args_(args),
         return_type_(return_type),
         body_(body) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::FunctionDecl;
+  }
+
   static FunctionDecl* Create(ASTContext& ctx, SourceRange loc,
-                              const std::string& name, Type* type,
+                              IdentifierInfo* name, Type* type,
                               Type* return_type);
 
   static FunctionDecl* Create(ASTContext& ctx, SourceRange loc,
-                              std::string name, std::vector<VarDecl*> args,
-                              Type* type, Type* return_type, Stmt* body);
+                              IdentifierInfo* name,
+                              std::span<VarDecl* const> args, Type* type,
+                              Type* return_type, Stmt* body);
 
-  void AddLocal(Decl* decl) { locals_.push_back(decl); }
-
-  void AddLocals(const std::vector<Decl*>& decls) {
-    locals_.insert(locals_.end(), decls.begin(), decls.end());
-  }
+  // The variables declared anywhere in the body, owned by the ASTContext.
+  void SetLocals(std::span<Decl*> locals) { locals_ = locals; }
 
   void SetStackSize(int stack_size) { stack_size_ = stack_size; }
 
@@ -103,7 +114,7 @@ class FunctionDecl : public Decl {
 
   [[nodiscard]] bool HasDefinition() const { return body_ != nullptr; }
 
-  std::vector<Decl*> GetLocals() { return locals_; }
+  [[nodiscard]] std::span<Decl*> GetLocals() const { return locals_; }
 
   [[nodiscard]] bool IsMain() const { return GetName() == "main"; }
 
@@ -113,34 +124,33 @@ class FunctionDecl : public Decl {
 
   void SetBody(Stmt* body) { body_ = body; }
 
-  void SetParams(std::vector<VarDecl*> params) { args_ = std::move(params); }
+  // Owned by the ASTContext.
+  void SetParams(std::span<VarDecl*> params) { args_ = params; }
   VarDecl* GetParam(std::size_t index) { return args_[index]; }
 
   [[nodiscard]] std::size_t GetParamNum() const { return args_.size(); }
-
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 // FIXME: Does RecordDecl has a type?
 class RecordDecl : public Decl {
-  std::vector<VarDecl*> members_;
+  std::span<VarDecl*> members_;
 
-  RecordDecl(SourceRange loc, std::string name, std::vector<VarDecl*> members)
-      : Decl(std::move(loc), std::move(name), /*type=*/nullptr),
-        members_(std::move(members)) {}
+  RecordDecl(SourceRange loc, IdentifierInfo* name,
+             std::span<VarDecl*> members)
+      : Decl(ASTNodeKind::RecordDecl, loc, name, /*type=*/nullptr),
+        members_(members) {}
 
  public:
-  static RecordDecl* Create(ASTContext& ctx, SourceRange loc, std::string name,
-                            std::vector<VarDecl*> members);
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::RecordDecl;
+  }
+
+  static RecordDecl* Create(ASTContext& ctx, SourceRange loc,
+                            IdentifierInfo* name,
+                            std::span<VarDecl* const> members);
 
   VarDecl* GetMember(std::size_t index) { return members_[index]; }
 
   [[nodiscard]] std::size_t GetMemberNum() const { return members_.size(); }
-
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 }  // namespace jcc
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <utility>
+#include <vector>
 
 #include "jcc/ast_context.h"
 #include "jcc/type.h"
@@ -127,10 +129,8 @@ class DeclSpec {
       default:
         jcc_unreachable("Unknown type specifier when generating type!");
     }
-    type_->SetQualifiers(static_cast<Qualifiers>(type_qual_));
-    if (IsStatic()) {
-      type_->SetStatic();
-    }
+    type_ = ctx_.GetQualifiedType(type_, static_cast<Qualifiers>(type_qual_),
+                                  IsStatic());
   }
 
   [[nodiscard]] Type* GetType() const { return type_; }
@@ -193,6 +193,10 @@ class Declarator {
   // Maybe a mutbale referecnce is enough
   friend class Parser;
   DeclSpec& decl_spec_;
+  // Names live here rather than on the type, types are shared.
+  IdentifierInfo* name_ = nullptr;
+  // The names of the parameters, if this declares a function.
+  std::vector<IdentifierInfo*> param_names_;
 
  public:
   explicit Declarator(DeclSpec& decl_spec) : decl_spec_(decl_spec) {}
@@ -207,8 +211,16 @@ class Declarator {
 
   void SetType(Type* type) { decl_spec_.SetType(type); }
 
-  std::string GetName() { return decl_spec_.GetType()->GetNameAsString(); }
+  [[nodiscard]] IdentifierInfo* GetName() const { return name_; }
+
+  void SetName(const Token& name) { name_ = name.GetIdentifierInfo(); }
 
-  void SetName(const Token& name) { decl_spec_.GetType()->SetName(name); }
+  [[nodiscard]] const std::vector<IdentifierInfo*>& GetParamNames() const {
+    return param_names_;
+  }
+
+  void SetParamNames(std::vector<IdentifierInfo*> names) {
+    param_names_ = std::move(names);
+  }
 };
 }  // namespace jcc
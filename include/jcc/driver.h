@@ -2,6 +2,8 @@
 
 #include <filesystem>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace jcc {
 
@@ -18,14 +20,32 @@ class Driver {
   bool opt_o_ = false;
 
   bool ast_dump_ = false;
+  // Tokenize the whole file before parsing instead of on demand.
+  bool lex_all_ = false;
+  // Lex on a second thread, overlapped with parsing.
+  bool pipeline_threads_ = false;
+  // Write object files ourselves rather than have `as` assemble them.
+  bool integrated_as_ = true;
+  // Stream the assembly into `as` through a pipe rather than have it read a
+  // .s file once it's complete. Implies -fno-integrated-as.
+  bool pipe_ = false;
+  // Compile into memory and run the program right away, like `tcc -run`.
+  bool run_ = false;
+  // The arguments of the program run, the source file first.
+  std::vector<std::string> run_args_;
+
+  // What Assemble() produces.
+  enum class Output { ASTDump, Assembly, PipedAssembly, Object, Run };
 
  public:
   Driver(int argc, char** argv);
-  void Run();
+  // Returns the exit status.
+  int Run();
 
  private:
-  void Assemble(const std::string& content, const std::string& source_file,
-                bool ast_dump = false);
+  // Returns the exit status of the program for Output::Run, 0 otherwise.
+  int Assemble(std::string_view content, const std::string& source_file,
+               Output output);
   void Compile();
   void Link();
 
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jcc {
+
+class AsmBuffer;
+
+struct ObjectRelocation {
+  // Where to apply it, relative to the start of the section.
+  std::uint64_t offset;
+  // Index into ObjectFile::symbols.
+  std::size_t symbol;
+  // One of R_X86_64_*.
+  std::uint32_t type;
+  std::int64_t addend;
+};
+
+struct ObjectSection {
+  std::string name;
+  // One of SHT_*.
+  std::uint32_t type;
+  // SHF_* bits.
+  std::uint64_t flags;
+  std::uint64_t alignment = 1;
+  std::string data;
+  std::vector<ObjectRelocation> relocations;
+};
+
+struct ObjectSymbol {
+  std::string name;
+  // The section header index: SHN_UNDEF, SHN_ABS, or one more than the
+  // index into ObjectFile::sections, as the null section comes first.
+  std::uint16_t section;
+  std::uint64_t value = 0;
+  std::uint64_t size = 0;
+  // STB_* and STT_*.
+  unsigned char binding;
+  unsigned char type;
+};
+
+// The contents of a relocatable object, in whatever order was convenient to
+// build them in. The writer takes care of what ELF is picky about, like
+// local symbols coming first.
+struct ObjectFile {
+  std::vector<ObjectSection> sections;
+  std::vector<ObjectSymbol> symbols;
+};
+
+// Lays `object` out as an ELF64 x86-64 relocatable file, appending it to
+// `out`. Relocation, symbol and string tables are generated.
+void WriteElf(const ObjectFile& object, AsmBuffer& out);
+}  // namespace jcc
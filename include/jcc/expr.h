@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <span>
+#include <string_view>
 
 #include "jcc/source_location.h"
 #include "jcc/stmt.h"
@@ -19,86 +21,94 @@ class Expr : public Stmt {
   Type* type_ = nullptr;
 
  protected:
-  explicit Expr(SourceRange loc, Type* type)
-      : Stmt(std::move(loc)), type_(type) {}
+  Expr(ASTNodeKind kind, SourceRange loc, Type* type)
+      : Stmt(kind, loc), type_(type) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() >= ASTNodeKind::FirstExpr &&
+           node->GetKind() <= ASTNodeKind::LastExpr;
+  }
+
   Type* GetType() {
     assert(type_ && "Expr's type can't be null!");
     return type_;
   }
 
   void SetType(Type* type) { type_ = type; }
-
-  ~Expr() override;
 };
 
 class StringLiteral : public Expr {
-  std::string literal_;
+  // Points into the source if the literal has no escape sequences, and to a
+  // decoded copy in the ASTContext otherwise. Not null-terminated.
+  std::string_view literal_;
 
-  StringLiteral(SourceRange loc, Type* type, std::string literal)
-      : Expr(std::move(loc), type), literal_(std::move(literal)) {}
+  StringLiteral(SourceRange loc, Type* type, std::string_view literal)
+      : Expr(ASTNodeKind::StringLiteral, loc, type), literal_(literal) {}
 
  public:
-  static StringLiteral* Create(ASTContext& ctx, SourceRange loc,
-                               std::string literal);
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::StringLiteral;
+  }
 
-  [[nodiscard]] std::string GetValue() const { return literal_; }
-  void dump(int indent) const override;
+  // `spelling` is what's between the quotes.
+  static StringLiteral* Create(ASTContext& ctx, SourceRange loc,
+                               std::string_view spelling);
 
-  void GenCode(CodeGen& gen) override;
+  [[nodiscard]] std::string_view GetValue() const { return literal_; }
 };
 
 class CharacterLiteral : public Expr {
   // TODO(Jun): Support more character kinds.
-  std::string value_;
+  char value_;
 
-  CharacterLiteral(SourceRange loc, Type* type, std::string value)
-      : Expr(std::move(loc), type), value_(std::move(value)) {}
+  CharacterLiteral(SourceRange loc, Type* type, char value)
+      : Expr(ASTNodeKind::CharacterLiteral, loc, type), value_(value) {}
 
  public:
-  static CharacterLiteral* Create(ASTContext& ctx, SourceRange loc, Type* type,
-                                  std::string value);
-
-  [[nodiscard]] std::string GetValue() const { return value_; }
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::CharacterLiteral;
+  }
 
-  void dump(int indent) const override;
+  // `spelling` is what's between the quotes.
+  static CharacterLiteral* Create(ASTContext& ctx, SourceRange loc, Type* type,
+                                  std::string_view spelling);
 
-  void GenCode(CodeGen& gen) override;
+  [[nodiscard]] char GetValue() const { return value_; }
 };
 
 class IntergerLiteral : public Expr {
   int value_{0};
 
   IntergerLiteral(SourceRange loc, Type* type, int value)
-      : Expr(std::move(loc), type), value_(value) {}
+      : Expr(ASTNodeKind::IntergerLiteral, loc, type), value_(value) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::IntergerLiteral;
+  }
+
   static IntergerLiteral* Create(ASTContext& ctx, SourceRange loc, Type* type,
                                  int value);
 
   [[nodiscard]] int GetValue() const { return value_; }
-
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class FloatingLiteral : public Expr {
   double value_{0};
 
   FloatingLiteral(SourceRange loc, Type* type, double value)
-      : Expr(std::move(loc), type), value_(value) {}
+      : Expr(ASTNodeKind::FloatingLiteral, loc, type), value_(value) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::FloatingLiteral;
+  }
+
   static FloatingLiteral* Create(ASTContext& ctx, SourceRange loc, Type* type,
                                  double value);
 
   [[nodiscard]] double GetValue() const { return value_; }
-
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class ConstantExpr : public Expr {
@@ -107,24 +117,24 @@ class ConstantExpr : public Expr {
 
 class CallExpr : public Expr {
   Expr* callee_ = nullptr;
-  std::vector<Expr*> args_;
+  std::span<Expr*> args_;
 
-  CallExpr(SourceRange loc, Type* type, Expr* callee, std::vector<Expr*> args)
-      : Expr(std::move(loc), type), callee_(callee), args_(std::move(args)) {}
+  CallExpr(SourceRange loc, Type* type, Expr* callee, std::span<Expr*> args)
+      : Expr(ASTNodeKind::CallExpr, loc, type), callee_(callee), args_(args) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::CallExpr;
+  }
+
   static CallExpr* Create(ASTContext& ctx, SourceRange loc, Type* type,
-                          Expr* callee, std::vector<Expr*> args);
+                          Expr* callee, std::span<Expr* const> args);
 
   [[nodiscard]] Expr* GetCallee() const { return callee_; }
 
   Expr* GetArg(std::size_t index) { return args_[index]; }
 
   [[nodiscard]] std::size_t GetArgNum() const { return args_.size(); }
-
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class CastExpr : public Expr {
@@ -148,19 +158,19 @@ class UnaryExpr : public Expr {
   Stmt* value_ = nullptr;
 
   UnaryExpr(SourceRange loc, Type* type, UnaryOperatorKind kind, Stmt* value)
-      : Expr(std::move(loc), type), kind_(kind), value_(value) {}
+      : Expr(ASTNodeKind::UnaryExpr, loc, type), kind_(kind), value_(value) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::UnaryExpr;
+  }
+
   static UnaryExpr* Create(ASTContext& ctx, SourceRange loc, Type* type,
                            UnaryOperatorKind kind, Stmt* value);
 
   [[nodiscard]] UnaryOperatorKind getKind() const { return kind_; }
 
   Stmt* GetValue() { return value_; }
-
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 // TODO(Jun): Add more kinds.
@@ -188,9 +198,16 @@ class BinaryExpr : public Expr {
 
   BinaryExpr(SourceRange loc, Type* type, BinaryOperatorKind kind, Expr* lhs,
              Expr* rhs)
-      : Expr(std::move(loc), type), kind_(kind), lhs_(lhs), rhs_(rhs) {}
+      : Expr(ASTNodeKind::BinaryExpr, loc, type),
+        kind_(kind),
+        lhs_(lhs),
+        rhs_(rhs) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::BinaryExpr;
+  }
+
   static BinaryExpr* Create(ASTContext& ctx, SourceRange loc, Type* type,
                             BinaryOperatorKind kind, Expr* lhs, Expr* rhs);
 
@@ -199,10 +216,6 @@ class BinaryExpr : public Expr {
   Expr* GetLhs() { return lhs_; }
 
   Expr* GetRhs() { return rhs_; }
-
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class MemberExpr : public Expr {
@@ -210,35 +223,37 @@ class MemberExpr : public Expr {
   Decl* member_{nullptr};
 
   MemberExpr(SourceRange loc, Type* type, Stmt* base, Decl* member)
-      : Expr(std::move(loc), type), base_(base), member_(member) {}
+      : Expr(ASTNodeKind::MemberExpr, loc, type),
+        base_(base),
+        member_(member) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::MemberExpr;
+  }
+
   static MemberExpr* create(ASTContext& ctx, SourceRange loc, Stmt* base,
                             Decl* member);
 
   Stmt* getBase() { return base_; }
 
   Decl* getMember() { return member_; }
-
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class DeclRefExpr : public Expr {
   Decl* decl_ = nullptr;
 
   DeclRefExpr(SourceRange loc, Type* type, Decl* decl)
-      : Expr(std::move(loc), type), decl_(decl) {}
+      : Expr(ASTNodeKind::DeclRefExpr, loc, type), decl_(decl) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::DeclRefExpr;
+  }
+
   static DeclRefExpr* Create(ASTContext& ctx, SourceRange loc, Type* type,
                              Decl* decl);
 
   Decl* GetRefDecl() { return decl_; }
-
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 }  // namespace jcc
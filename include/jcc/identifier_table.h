@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string_view>
+#include <unordered_map>
+
+#include "jcc/allocator.h"
+#include "jcc/token.h"
+
+namespace jcc {
+
+// Everything we know about one spelling. There's exactly one IdentifierInfo
+// per spelling, so identifiers can be compared and hashed by address.
+class IdentifierInfo {
+  std::string_view name_;
+  // Identifier, or the keyword the spelling stands for.
+  TokenKind kind_;
+  // Set once the spelling has been declared as a typedef name or a tag
+  // anywhere. Most identifiers never are, which saves a scope lookup in the
+  // parser whenever it wonders whether an identifier starts a type.
+  bool maybe_type_name_ = false;
+
+  friend class IdentifierTable;
+
+  IdentifierInfo(std::string_view name, TokenKind kind)
+      : name_(name), kind_(kind) {}
+
+ public:
+  IdentifierInfo(const IdentifierInfo&) = delete;
+  IdentifierInfo& operator=(const IdentifierInfo&) = delete;
+
+  [[nodiscard]] std::string_view GetName() const { return name_; }
+
+  [[nodiscard]] TokenKind GetTokenKind() const { return kind_; }
+
+  [[nodiscard]] bool IsKeyword() const {
+    return kind_ != TokenKind::Identifier;
+  }
+
+  [[nodiscard]] bool MaybeTypeName() const { return maybe_type_name_; }
+
+  void SetMaybeTypeName() { maybe_type_name_ = true; }
+};
+
+// Interns every spelling the lexer runs into. The IdentifierInfos and their
+// spellings live in an arena as long as the table does.
+class IdentifierTable {
+  std::unordered_map<std::string_view, IdentifierInfo*> table_;
+  Arena arena_;
+
+ public:
+  IdentifierTable() = default;
+  IdentifierTable(const IdentifierTable&) = delete;
+  IdentifierTable& operator=(const IdentifierTable&) = delete;
+
+  // Returns the IdentifierInfo of `name`, creating it if needed.
+  IdentifierInfo& Get(std::string_view name);
+
+  [[nodiscard]] std::size_t GetSize() const { return table_.size(); }
+};
+}  // namespace jcc
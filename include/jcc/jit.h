@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "jcc/elf_writer.h"
+
+namespace jcc {
+
+// An object file loaded into executable memory of this process, in place of
+// linking it into an executable. Symbols it leaves undefined are looked up
+// with dlsym() among what the process already has loaded, libc that is.
+//
+// The sections, a GOT and a stub for every external function that's called
+// directly share one mapping: the code and the stubs on pages that are
+// mapped executable once the relocations are applied, the GOT and the data
+// on writable pages after them. Everything within the image is in reach of
+// a 32-bit displacement, the stubs bridge the distance to libc.
+class JitImage {
+  char* base_ = nullptr;
+  std::size_t size_ = 0;
+  // The addresses of the global symbols it defines.
+  std::unordered_map<std::string, void*> symbols_;
+
+  JitImage() = default;
+
+ public:
+  JitImage(const JitImage&) = delete;
+  JitImage& operator=(const JitImage&) = delete;
+  ~JitImage();
+
+  // Returns nullptr, after telling why, if a symbol can't be resolved or
+  // the memory can't be mapped.
+  static std::unique_ptr<JitImage> Load(const ObjectFile& object);
+
+  // Returns the address of the global symbol `name`, nullptr if there's no
+  // such symbol.
+  [[nodiscard]] void* GetSymbol(std::string_view name) const;
+};
+}  // namespace jcc
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+#include "jcc/token.h"
+
+namespace jcc {
+
+// A compile-time perfect hash over the C11 keywords. The hash only looks at
+// the first two characters, the last character and the length of a spelling,
+// so matching an identifier costs one hash, one table probe and at most one
+// string comparison. No keyword is shorter than 2 characters, which keeps
+// the hash from reading past the spelling.
+class Keywords {
+  struct Entry {
+    std::string_view spelling;
+    TokenKind kind = TokenKind::Unspecified;
+  };
+
+  static constexpr Entry keywords[] = {
+      {"alignof", TokenKind::AlignOf},
+      {"auto", TokenKind::Auto},
+      {"break", TokenKind::Break},
+      {"case", TokenKind::Case},
+      {"char", TokenKind::Char},
+      {"const", TokenKind::Const},
+      {"continue", TokenKind::Continue},
+      {"default", TokenKind::Default},
+      {"do", TokenKind::Do},
+      {"double", TokenKind::Double},
+      {"else", TokenKind::Else},
+      {"enum", TokenKind::Enum},
+      {"extern", TokenKind::Extern},
+      {"float", TokenKind::Float},
+      {"for", TokenKind::For},
+      {"goto", TokenKind::Goto},
+      {"if", TokenKind::If},
+      {"inline", TokenKind::Inline},
+      {"int", TokenKind::Int},
+      {"long", TokenKind::Long},
+      {"register", TokenKind::Register},
+      {"restrict", TokenKind::Restrict},
+      {"return", TokenKind::Return},
+      {"short", TokenKind::Short},
+      {"signed", TokenKind::Signed},
+      {"sizeof", TokenKind::Sizeof},
+      {"static", TokenKind::Static},
+      {"struct", TokenKind::Struct},
+      {"switch", TokenKind::Switch},
+      {"typedef", TokenKind::Typedef},
+      {"union", TokenKind::Union},
+      {"unsigned", TokenKind::Unsigned},
+      {"void", TokenKind::Void},
+      {"while", TokenKind::While},
+      {"_Alignas", TokenKind::DashAlignas},
+      {"_Atomic", TokenKind::DashAtmoic},
+      {"_Bool", TokenKind::DashBool},
+      {"_Complex", TokenKind::DashComplex},
+      {"_Generic", TokenKind::DashGeneric},
+      {"_Imaginary", TokenKind::DashImaginary},
+      {"_Noreturn", TokenKind::DashNoReturn},
+      {"_Static_assert", TokenKind::DashStaticAssert},
+      {"_Thread_local", TokenKind::DashThreadLocal},
+  };
+
+  static constexpr std::size_t min_length = 2;
+  static constexpr std::size_t max_length = 14;
+  static constexpr std::size_t table_size = 128;
+
+  static constexpr std::size_t Hash(std::string_view spelling) {
+    return (static_cast<unsigned char>(spelling[0]) * 2 +
+            static_cast<unsigned char>(spelling[1]) * 16 +
+            static_cast<unsigned char>(spelling.back()) +
+            spelling.size() * 10) &
+           (table_size - 1);
+  }
+
+  static constexpr std::array<Entry, table_size> BuildTable();
+
+  static const std::array<Entry, table_size> table;
+
+ public:
+  static constexpr bool IsPerfect();
+
+  static constexpr std::optional<TokenKind> Match(std::string_view identifier) {
+    if (identifier.size() < min_length || identifier.size() > max_length) {
+      return std::nullopt;
+    }
+    const Entry& entry = table[Hash(identifier)];
+    if (entry.spelling != identifier) {
+      return std::nullopt;
+    }
+    return entry.kind;
+  }
+};
+
+constexpr std::array<Keywords::Entry, Keywords::table_size>
+Keywords::BuildTable() {
+  std::array<Entry, table_size> table{};
+  for (const Entry& entry : keywords) {
+    table[Hash(entry.spelling)] = entry;
+  }
+  return table;
+}
+
+inline constexpr std::array<Keywords::Entry, Keywords::table_size>
+    Keywords::table = Keywords::BuildTable();
+
+// Every keyword must have landed in its own slot, otherwise the hash is no
+// longer perfect and needs new coefficients.
+constexpr bool Keywords::IsPerfect() {
+  for (const Entry& entry : keywords) {
+    if (entry.spelling.size() < min_length ||
+        entry.spelling.size() > max_length ||
+        table[Hash(entry.spelling)].spelling != entry.spelling) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(Keywords::IsPerfect(), "Keyword hash has collisions!");
+}  // namespace jcc
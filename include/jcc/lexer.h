@@ -1,48 +1,58 @@
 #pragma once
-#include <optional>
-#include <string>
-#include <string_view>
-#include <unordered_map>
-#include <utility>
-
+#include "jcc/char_scanner.h"
+#include "jcc/identifier_table.h"
+#include "jcc/source_manager.h"
+#include "jcc/spsc_queue.h"
 #include "jcc/token.h"
+#include "jcc/token_buffer.h"
 
 namespace jcc {
-class Keywords {
-  std::unordered_map<std::string_view, TokenKind> keywords_;
 
- public:
-  Keywords();
-
-  std::optional<TokenKind> matchKeyword(std::string_view identifier);
-};
+// Carries tokens from a lexer thread to the parser.
+using TokenQueue = SPSCQueue<Token, 1024>;
 
 // the lexer is not responsible for managing the buffer, instead it's an
-// observer.
+// observer. The buffer must be NUL terminated, the character scanners rely on
+// it to stop.
 class Lexer {
-  std::string file_name_;
+  SourceManager& source_mgr_;
+  FileID file_id_;
+  IdentifierTable& idents_;
   const char* buffer_start_;
   const char* buffer_end_;
   const char* buffer_ptr_;
+  // The location of `buffer_start_`.
+  SourceLocation file_loc_;
 
-  std::size_t line_ = 1;
-  std::size_t column_ = 1;
-
-  Keywords keywords_;
+  const CharScanner& scanner_ = CharScanner::Get();
 
  public:
-  explicit Lexer(std::string_view source, std::string name = "<Buffer>")
-      : file_name_(std::move(name)),
-        // FIXME: we can't initialize const char* with string_view::begin(),
-        // it's implementation defined.
-        buffer_start_(source.data()),
-        buffer_end_(source.data() + source.length()),
-        buffer_ptr_(source.data()) {}
+  Lexer(SourceManager& source_mgr, FileID file_id, IdentifierTable& idents)
+      : source_mgr_(source_mgr),
+        file_id_(file_id),
+        idents_(idents),
+        buffer_start_(source_mgr.GetBuffer(file_id).data()),
+        buffer_end_(buffer_start_ + source_mgr.GetBuffer(file_id).length()),
+        buffer_ptr_(buffer_start_),
+        file_loc_(source_mgr.GetLocForStartOfFile(file_id)) {}
 
   Token Lex();
 
+  // Lexes the rest of the file in one go, up to and including Eof.
+  TokenBuffer LexAll();
+
+  // Lexes the rest of the file into `queue`, up to and including Eof. Meant
+  // to run on its own thread, ahead of a parser draining the queue.
+  void LexAll(TokenQueue& queue);
+
   [[nodiscard]] bool HasDone() const;
 
+  [[nodiscard]] SourceManager& GetSourceManager() const { return source_mgr_; }
+
+  [[nodiscard]] FileID GetFileID() const { return file_id_; }
+
+  [[nodiscard]] IdentifierTable& GetIdentifierTable() const { return idents_; }
+
  private:
   Token LexAtom(TokenKind kind);
   Token LexAtom(TokenKind kind, SourceLocation loc);
@@ -52,13 +62,11 @@ class Lexer {
   Token LexNumericConstant();
 
   void SkipWhitespace();
-  void SkipUntil(char cha, bool skip_match = false);
+  void SkipBlockComment();
   void Advance();
   char Peek() const;
   char PeekAhead(int offset = 1) const;
   bool TryConsume(char cha);
-  std::size_t GetOffset() const;
-  [[nodiscard]] bool IsValidChar() const;
-  [[nodiscard]] bool IsLineTerminator() const;
+  SourceLocation GetLocation() const;
 };
 }  // namespace jcc
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace jcc {
+
+// Maps byte offsets within one buffer back to line and column numbers. The
+// lexer only ever records offsets, the SourceManager builds the table once,
+// on demand, when something actually wants to show a location to the user.
+class LineTable {
+  // The offset of the first character of every line, in ascending order.
+  std::vector<std::uint32_t> line_starts_;
+
+ public:
+  explicit LineTable(std::string_view buffer);
+
+  [[nodiscard]] std::size_t GetNumLines() const { return line_starts_.size(); }
+
+  // Both are 1-based, like every compiler diagnostic out there.
+  [[nodiscard]] std::size_t GetLineNumber(std::uint32_t offset) const;
+  [[nodiscard]] std::size_t GetColumnNumber(std::uint32_t offset) const;
+};
+}  // namespace jcc
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace jcc {
+
+// The read only contents of a source file, always followed by a NUL, so the
+// lexer can run until it hits one without ever checking for the end of the
+// buffer.
+//
+// Large files are mapped into memory, the rest of the last page is zero
+// filled by the kernel, and when the file ends right at a page boundary an
+// extra zero page is mapped behind it. Small files, pipes and stdin aren't
+// worth a mapping and are read into a heap buffer in one go instead.
+class MemoryBuffer {
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+  // The length of the mapping starting at `data_`, 0 if it lives on the heap.
+  std::size_t mapped_size_ = 0;
+
+  MemoryBuffer() = default;
+
+ public:
+  MemoryBuffer(const MemoryBuffer&) = delete;
+  MemoryBuffer& operator=(const MemoryBuffer&) = delete;
+  ~MemoryBuffer();
+
+  // Returns nullptr if the file can't be read.
+  static std::unique_ptr<MemoryBuffer> GetFile(std::string_view path);
+
+  static std::unique_ptr<MemoryBuffer> GetSTDIN();
+
+  [[nodiscard]] std::string_view GetBuffer() const { return {data_, size_}; }
+
+  [[nodiscard]] bool IsMapped() const { return mapped_size_ != 0; }
+
+ private:
+  // Reads `fd` until EOF. A nonzero `size_hint` is the size of a regular
+  // file, which is read up to that much without checking for EOF.
+  static std::unique_ptr<MemoryBuffer> Read(int fd, std::size_t size_hint);
+
+  static std::unique_ptr<MemoryBuffer> Map(int fd, std::size_t size);
+};
+}  // namespace jcc
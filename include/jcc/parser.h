@@ -1,12 +1,18 @@
 #pragma once
 
-#include <optional>
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
 
 #include "jcc/ast_context.h"
 #include "jcc/declarator.h"
 #include "jcc/expr.h"
+#include "jcc/lexer.h"
+#include "jcc/small_vector.h"
 #include "jcc/stmt.h"
 #include "jcc/token.h"
+#include "jcc/token_buffer.h"
 
 namespace jcc {
 
@@ -15,7 +21,6 @@ class Expr;
 class Parser;
 class VarDecl;
 class Stmt;
-class Lexer;
 
 enum class BinOpPreLevel {
   Unknown = 0,         // Not binary operator.
@@ -39,6 +44,15 @@ class Parser {
  public:
   explicit Parser(Lexer& lexer);
 
+  // Parses the tokens `lexer` has already lexed into `tokens`, see
+  // Lexer::LexAll(). The lexer is only used for its IdentifierTable then.
+  Parser(Lexer& lexer, const TokenBuffer& tokens);
+
+  // Parses the tokens another thread publishes into `tokens` while lexing
+  // with `lexer`, see Lexer::LexAll(TokenQueue&). New identifiers must not be
+  // interned while that thread runs, the IdentifierTable isn't thread safe.
+  Parser(Lexer& lexer, TokenQueue& tokens);
+
   std::vector<Decl*> ParseTranslateUnit();
 
   void SkipUntil(TokenKind kind, bool skip_match = false);
@@ -51,7 +65,8 @@ class Parser {
 
   std::vector<Decl*> ParseFunctionOrVar(DeclSpec& decl_spec);
 
-  std::vector<Decl*> ParseDeclaration(Declarator& declarator);
+  // Appends the declared variables to `decls`.
+  void ParseDeclaration(Declarator& declarator, SmallVectorImpl<Decl*>& decls);
 
   Stmt* ParseStatement();
 
@@ -89,19 +104,19 @@ class Parser {
 
   Expr* ParsePostfixExpr(Expr* lhs);
 
-  std::vector<Expr*> ParseExprList();
+  void ParseExprList(SmallVectorImpl<Expr*>& exprs);
 
   Decl* ParseFunction(Declarator& declarator);
 
   Type* ParseRecordType(TokenKind kind);
 
-  std::vector<Type*> ParseMembers();
+  void ParseMembers(SmallVectorImpl<Type*>& members);
 
-  Type* ParseParams(Type* type);
+  Type* ParseParams(Type* type, Declarator& declarator);
 
-  Type* ParseArrayDimensions(Type* type);
+  Type* ParseArrayDimensions(Type* type, Declarator& declarator);
 
-  Type* ParseTypeSuffix(Type* type);
+  Type* ParseTypeSuffix(Type* type, Declarator& declarator);
 
   Type* ParsePointers(Declarator& declarator);
 
@@ -109,30 +124,58 @@ class Parser {
 
   void ParseTypedef(DeclSpec& decl_spec);
 
-  std::vector<VarDecl*> CreateParams(FunctionType* type);
+  std::span<VarDecl*> CreateParams(FunctionType* type,
+                                   const std::vector<IdentifierInfo*>& names);
 
   ASTContext& GetASTContext() { return ctx_; }
 
-  [[nodiscard]] Decl* Lookup(const std::string& name) const {
+  [[nodiscard]] Decl* Lookup(const IdentifierInfo* name) const {
     return ctx_.Lookup(name);
   }
-  [[nodiscard]] Type* LookupType(const std::string& name) const {
+  [[nodiscard]] Type* LookupType(const IdentifierInfo* name) const {
     return ctx_.LookupType(name);
   }
-  Scope& GetCurScope() { return ctx_.GetCurScope(); }
 
  private:
   Token CurrentToken();
   Token ConsumeToken();
   void MustConsumeToken(TokenKind expected);
   bool TryConsumeToken(TokenKind expected);
-  Token NextToken();
+  // Returns the token `n` tokens after the current one, PeekToken(0) being
+  // the current token. `n` must be less than lookahead_capacity.
+  Token PeekToken(std::size_t n);
+  // Lexes tokens, or takes them from token_buffer_ or token_queue_, until
+  // the lookahead buffer is full or Eof has been reached. Stops early once it
+  // holds `count` tokens if more would mean waiting for the lexer thread.
+  void FillTokens(std::size_t count);
   [[nodiscard]] bool IsType(Token token) const;
   Lexer& lexer_;
-  Token token_;
-  std::optional<Token> cache_;
+
+  // Set when parsing pre-lexed tokens, next_token_ indexes the first one not
+  // taken into the lookahead buffer yet.
+  const TokenBuffer* token_buffer_ = nullptr;
+  std::size_t next_token_ = 0;
+  // Set when another thread is lexing.
+  TokenQueue* token_queue_ = nullptr;
+
+  // A ring buffer of the tokens lexed ahead of the parser, refilled in
+  // batches whenever it runs dry. tokens_[head_] is the current token and the
+  // following num_tokens_ - 1 slots, wrapping around, are the lookahead.
+  static constexpr std::size_t lookahead_capacity = 64;
+  static_assert((lookahead_capacity & (lookahead_capacity - 1)) == 0,
+                "The capacity must be a power of 2!");
+  std::array<Token, lookahead_capacity> tokens_;
+  std::size_t head_ = 0;
+  std::size_t num_tokens_ = 0;
+  bool reached_eof_ = false;
+
   ASTContext ctx_;
 
+  // The locals of the functions being parsed. Functions may be declared in
+  // a function body, so each one only owns the locals past where they ended
+  // when it started, and takes them off once it has been parsed.
+  std::vector<Decl*> locals_;
+
   class ScopeRAII {
     ASTContext& self_;
 
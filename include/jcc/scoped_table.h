@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace jcc {
+
+class IdentifierInfo;
+
+// Maps identifiers to the innermost declaration visible for them, across all
+// scopes at once.
+//
+// Every identifier owns at most one slot in a flat open addressing table
+// holding its current binding. Binding a name records the binding it shadows
+// on an undo stack, and leaving a scope pops that stack back to where the
+// scope began. Lookups are a single probe sequence no matter how deeply the
+// scopes nest, and entering a scope costs nothing but a mark.
+//
+// Identifiers are interned, so they're hashed and compared by address, and
+// since their number is finite, slots are never freed: a slot whose binding
+// went out of scope just maps to nullptr until the identifier comes back.
+template <typename T>
+class ScopedTable {
+  struct Slot {
+    const IdentifierInfo* key = nullptr;
+    T* value = nullptr;
+  };
+
+  struct Shadowed {
+    const IdentifierInfo* key;
+    T* value;
+  };
+
+  static constexpr std::size_t initial_capacity = 64;
+
+  // The size is always a power of two.
+  std::vector<Slot> slots_ = std::vector<Slot>(initial_capacity);
+  std::size_t used_ = 0;
+  std::vector<Shadowed> undo_;
+  // Where each open scope starts in `undo_`.
+  std::vector<std::size_t> scopes_;
+
+ public:
+  void EnterScope() { scopes_.push_back(undo_.size()); }
+
+  void ExitScope() {
+    assert(!scopes_.empty() && "No scope to exit!");
+    for (std::size_t mark = scopes_.back(); undo_.size() > mark;) {
+      const Shadowed& shadowed = undo_.back();
+      FindSlot(shadowed.key).value = shadowed.value;
+      undo_.pop_back();
+    }
+    scopes_.pop_back();
+  }
+
+  // Binds `key` to `value` until the current scope is exited.
+  void Insert(const IdentifierInfo* key, T* value) {
+    assert(!scopes_.empty() && "Can't insert without a scope!");
+    Slot* slot = &FindSlot(key);
+    if (slot->key == nullptr) {
+      // Keep the load factor under 3/4.
+      if ((used_ + 1) * 4 > slots_.size() * 3) {
+        Grow();
+        slot = &FindSlot(key);
+      }
+      slot->key = key;
+      used_++;
+    }
+    undo_.push_back({key, slot->value});
+    slot->value = value;
+  }
+
+  [[nodiscard]] T* Lookup(const IdentifierInfo* key) const {
+    return FindSlot(key).value;
+  }
+
+  [[nodiscard]] std::size_t GetDepth() const { return scopes_.size(); }
+
+ private:
+  [[nodiscard]] std::size_t Hash(const IdentifierInfo* key) const {
+    // Fibonacci hashing, the low bits of an address carry no information.
+    auto bits = reinterpret_cast<std::uintptr_t>(key);
+    return (bits * 0x9E3779B97F4A7C15ULL) >> (64 - Log2(slots_.size()));
+  }
+
+  static std::size_t Log2(std::size_t size) { return __builtin_ctzll(size); }
+
+  // Returns the slot of `key`, or the empty slot where it belongs.
+  Slot& FindSlot(const IdentifierInfo* key) {
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t idx = Hash(key);; idx = (idx + 1) & mask) {
+      Slot& slot = slots_[idx];
+      if (slot.key == key || slot.key == nullptr) {
+        return slot;
+      }
+    }
+  }
+
+  [[nodiscard]] const Slot& FindSlot(const IdentifierInfo* key) const {
+    return const_cast<ScopedTable*>(this)->FindSlot(key);
+  }
+
+  void Grow() {
+    std::vector<Slot> old = std::move(slots_);
+    slots_ = std::vector<Slot>(old.size() * 2);
+    for (const Slot& slot : old) {
+      if (slot.key != nullptr) {
+        FindSlot(slot.key) = slot;
+      }
+    }
+  }
+};
+}  // namespace jcc
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+namespace jcc {
+
+// The part of a SmallVector which doesn't depend on its inline capacity, so
+// functions can fill a SmallVector of any size.
+//
+// Only meant for scratch lists of trivially copyable things, like node
+// pointers, which are built up while parsing and then copied into the
+// ASTContext once complete.
+template <typename T>
+class SmallVectorImpl {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Elements are moved around with memcpy!");
+
+  T* data_;
+  std::size_t size_ = 0;
+  std::size_t capacity_;
+  // Set once the elements outgrow the inline storage.
+  std::unique_ptr<T[]> heap_;
+
+ protected:
+  SmallVectorImpl(T* inline_data, std::size_t inline_capacity)
+      : data_(inline_data), capacity_(inline_capacity) {}
+
+ public:
+  SmallVectorImpl(const SmallVectorImpl&) = delete;
+  SmallVectorImpl& operator=(const SmallVectorImpl&) = delete;
+
+  void push_back(T value) {
+    if (size_ == capacity_) {
+      Grow(capacity_ * 2);
+    }
+    data_[size_++] = value;
+  }
+
+  template <typename Iter>
+  void append(Iter first, Iter last) {
+    const auto count = static_cast<std::size_t>(std::distance(first, last));
+    if (size_ + count > capacity_) {
+      Grow(std::max(capacity_ * 2, size_ + count));
+    }
+    std::copy(first, last, data_ + size_);
+    size_ += count;
+  }
+
+  // Drops the elements past the first `size`.
+  void truncate(std::size_t size) {
+    assert(size <= size_ && "Can't truncate to a larger size!");
+    size_ = size;
+  }
+
+  void clear() { size_ = 0; }
+
+  [[nodiscard]] std::size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+  T* data() { return data_; }
+  const T* data() const { return data_; }
+
+  T* begin() { return data_; }
+  T* end() { return data_ + size_; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+
+  T& operator[](std::size_t index) {
+    assert(index < size_ && "Index out of range!");
+    return data_[index];
+  }
+  const T& operator[](std::size_t index) const {
+    assert(index < size_ && "Index out of range!");
+    return data_[index];
+  }
+
+  T& back() {
+    assert(!empty() && "No elements!");
+    return data_[size_ - 1];
+  }
+
+ private:
+  void Grow(std::size_t capacity) {
+    auto heap = std::make_unique_for_overwrite<T[]>(capacity);
+    std::copy(data_, data_ + size_, heap.get());
+    heap_ = std::move(heap);
+    data_ = heap_.get();
+    capacity_ = capacity;
+  }
+};
+
+// A vector which keeps up to N elements inline before going to the heap.
+template <typename T, std::size_t N>
+class SmallVector : public SmallVectorImpl<T> {
+  static_assert(N != 0, "Use a std::vector instead!");
+
+  T inline_[N];
+
+ public:
+  SmallVector() : SmallVectorImpl<T>(inline_, N) {}
+};
+}  // namespace jcc
@@ -1,52 +1,73 @@
 #pragma once
 
-#include <cstdio>
-#include <string>
-#include <string_view>
+#include <cstdint>
 
 namespace jcc {
+
+// Identifies a buffer registered with the SourceManager.
+class FileID {
+  // 0 is reserved for the invalid FileID.
+  std::uint32_t id_ = 0;
+
+ public:
+  FileID() = default;
+  explicit FileID(std::uint32_t id) : id_(id) {}
+
+  [[nodiscard]] bool IsValid() const { return id_ != 0; }
+
+  [[nodiscard]] std::uint32_t GetID() const { return id_; }
+
+  bool operator==(const FileID&) const = default;
+};
+
+// Like clang, every buffer the SourceManager knows about occupies its own
+// slice of one global offset space, so a 32-bit offset is enough to tell both
+// the file and the position within it. Use the SourceManager to turn it into
+// something readable.
 class SourceLocation {
-  std::size_t line_;
-  std::size_t column_;
-  std::size_t offset_;
+  // 0 is reserved for the invalid location.
+  std::uint32_t offset_ = 0;
 
  public:
   SourceLocation() = default;
-  SourceLocation(std::size_t line, std::size_t column, std::size_t offset)
-      : line_(line), column_(column), offset_(offset) {}
+  explicit SourceLocation(std::uint32_t offset) : offset_(offset) {}
+
+  [[nodiscard]] bool IsValid() const { return offset_ != 0; }
 
-  [[nodiscard]] std::size_t GetOffset() const { return offset_; }
+  [[nodiscard]] std::uint32_t GetOffset() const { return offset_; }
 
-  [[nodiscard]] std::size_t GetLine() const { return line_; }
+  [[nodiscard]] SourceLocation GetLocWithOffset(std::uint32_t offset) const {
+    return SourceLocation(offset_ + offset);
+  }
 
-  [[nodiscard]] std::size_t GetColumn() const { return column_; }
+  bool operator==(const SourceLocation&) const = default;
 };
 
 class SourceRange {
-  std::string file_name_;
   SourceLocation begin_;
   SourceLocation end_;
 
  public:
   SourceRange() = default;
 
-  SourceRange(std::string name, const SourceLocation& loc)
-      : file_name_(std::move(name)), begin_(loc), end_(loc) {}
+  explicit SourceRange(SourceLocation loc) : begin_(loc), end_(loc) {}
 
-  SourceRange(std::string name, const SourceLocation& beg,
-              const SourceLocation& end)
-      : file_name_(std::move(name)), begin_(beg), end_(end) {}
+  SourceRange(SourceLocation beg, SourceLocation end)
+      : begin_(beg), end_(end) {}
 
-  void SetBegin(const SourceLocation& loc) { begin_ = loc; }
+  void SetBegin(SourceLocation loc) { begin_ = loc; }
 
-  void SetEnd(const SourceLocation& loc) { begin_ = loc; }
+  void SetEnd(SourceLocation loc) { end_ = loc; }
 
-  SourceLocation GetBegin() { return begin_; }
+  [[nodiscard]] SourceLocation GetBegin() const { return begin_; }
 
-  SourceLocation GetEnd() { return end_; }
+  [[nodiscard]] SourceLocation GetEnd() const { return end_; }
 
-  void SetFileName(std::string name) { file_name_ = std::move(name); }
-
-  [[nodiscard]] std::string_view GetFileName() const { return file_name_; }
+  [[nodiscard]] bool IsValid() const {
+    return begin_.IsValid() && end_.IsValid();
+  }
 };
+
+static_assert(sizeof(SourceLocation) == 4);
+static_assert(sizeof(SourceRange) == 8);
 }  // namespace jcc
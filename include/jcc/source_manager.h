@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jcc/line_table.h"
+#include "jcc/source_location.h"
+
+namespace jcc {
+
+// Keeps track of every buffer taking part in a compilation and hands out the
+// FileIDs and SourceLocations referring to them. It doesn't own the buffers,
+// they must outlive it.
+class SourceManager {
+  struct FileInfo {
+    std::string name;
+    std::string_view buffer;
+    // Where the buffer starts in the global offset space.
+    std::uint32_t base = 0;
+    // Built the first time a line or a column is asked for.
+    mutable std::optional<LineTable> lines;
+  };
+
+  // Indexed by FileID - 1.
+  std::vector<FileInfo> files_;
+  // 0 is the invalid location, so the first buffer starts at 1.
+  std::uint32_t next_base_ = 1;
+
+ public:
+  // Registers a buffer, it must be NUL terminated for the lexer.
+  FileID AddBuffer(std::string name, std::string_view buffer);
+
+  [[nodiscard]] std::string_view GetBuffer(FileID fid) const {
+    return GetFileInfo(fid).buffer;
+  }
+
+  [[nodiscard]] std::string_view GetFileName(FileID fid) const {
+    return GetFileInfo(fid).name;
+  }
+
+  [[nodiscard]] SourceLocation GetLocForStartOfFile(FileID fid) const {
+    return SourceLocation(GetFileInfo(fid).base);
+  }
+
+  [[nodiscard]] FileID GetFileID(SourceLocation loc) const;
+
+  // The offset of `loc` from the start of its buffer.
+  [[nodiscard]] std::uint32_t GetFileOffset(SourceLocation loc) const;
+
+  [[nodiscard]] std::size_t GetLineNumber(SourceLocation loc) const;
+
+  [[nodiscard]] std::size_t GetColumnNumber(SourceLocation loc) const;
+
+ private:
+  [[nodiscard]] const FileInfo& GetFileInfo(FileID fid) const {
+    return files_[fid.GetID() - 1];
+  }
+
+  [[nodiscard]] const LineTable& GetLineTable(const FileInfo& info) const;
+};
+}  // namespace jcc
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+
+namespace jcc {
+
+// A bounded, lock-free queue for exactly one producer thread and one consumer
+// thread. The producer only ever writes tail_ and the consumer only head_,
+// each publishing its progress with a release store the other side picks up
+// with an acquire load, so a slot is never read and written concurrently.
+//
+// Each side also caches the last index it saw of the other one, which keeps
+// it from touching the other side's cache line on every operation.
+template <typename T, std::size_t Capacity>
+class SPSCQueue {
+  static_assert((Capacity & (Capacity - 1)) == 0,
+                "The capacity must be a power of 2!");
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Elements are copied in and out of their slots!");
+
+  static constexpr std::size_t cache_line_size = 64;
+  static constexpr std::size_t mask = Capacity - 1;
+
+  // Indices increase monotonically and are only masked to address a slot,
+  // so `tail - head` is the number of queued elements.
+  alignas(cache_line_size) std::atomic<std::size_t> head_{0};
+  std::size_t cached_tail_ = 0;
+
+  alignas(cache_line_size) std::atomic<std::size_t> tail_{0};
+  std::size_t cached_head_ = 0;
+
+  alignas(cache_line_size) std::array<T, Capacity> slots_;
+
+ public:
+  SPSCQueue() = default;
+  SPSCQueue(const SPSCQueue&) = delete;
+  SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+  // Producer side. Returns false if the queue is full.
+  bool TryPush(const T& value) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == Capacity) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == Capacity) {
+        return false;
+      }
+    }
+    slots_[tail & mask] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Producer side. Spins until there's room for `value`.
+  void Push(const T& value) {
+    while (!TryPush(value)) {
+      std::this_thread::yield();
+    }
+  }
+
+  // Consumer side. Returns false if the queue is empty.
+  bool TryPop(T& value) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return false;
+      }
+    }
+    value = slots_[head & mask];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Spins until there's an element to pop.
+  T Pop() {
+    T value;
+    while (!TryPop(value)) {
+      std::this_thread::yield();
+    }
+    return value;
+  }
+};
+}  // namespace jcc
@@ -1,9 +1,9 @@
 #pragma once
 
 #include <cassert>
-#include <optional>
-#include <string>
-#include <vector>
+#include <cstdint>
+#include <span>
+#include <string_view>
 
 #include "jcc/ast_node.h"
 #include "jcc/source_location.h"
@@ -17,10 +17,13 @@ class ASTContext;
 
 class Stmt : public ASTNode {
  protected:
-  explicit Stmt(SourceRange loc) : ASTNode(std::move(loc)) {}
+  Stmt(ASTNodeKind kind, SourceRange loc) : ASTNode(kind, loc) {}
 
  public:
-  ~Stmt() override;
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() >= ASTNodeKind::FirstStmt &&
+           node->GetKind() <= ASTNodeKind::LastStmt;
+  }
 };
 
 class LabeledStatement : public Stmt {
@@ -28,23 +31,32 @@ class LabeledStatement : public Stmt {
   Stmt* sub_stmt_ = nullptr;
 
   explicit LabeledStatement(SourceRange loc, LabelDecl* label, Stmt* sub_stmt)
-      : Stmt(std::move(loc)), label_(label), sub_stmt_(sub_stmt) {}
+      : Stmt(ASTNodeKind::LabeledStatement, loc),
+        label_(label),
+        sub_stmt_(sub_stmt) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::LabeledStatement;
+  }
+
   Stmt* GetSubStmt() { return sub_stmt_; }
   LabelDecl* GetLabel() { return label_; }
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class CompoundStatement : public Stmt {
-  std::vector<Stmt*> stmts_;
+  std::span<Stmt*> stmts_;
 
-  explicit CompoundStatement(SourceRange loc) : Stmt(std::move(loc)) {}
+  CompoundStatement(SourceRange loc, std::span<Stmt*> stmts)
+      : Stmt(ASTNodeKind::CompoundStatement, loc), stmts_(stmts) {}
 
  public:
-  static CompoundStatement* Create(ASTContext& ctx, SourceRange loc);
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::CompoundStatement;
+  }
+
+  static CompoundStatement* Create(ASTContext& ctx, SourceRange loc,
+                                   std::span<Stmt* const> stmts);
 
   [[nodiscard]] auto GetSize() const { return stmts_.size(); }
 
@@ -52,11 +64,6 @@ class CompoundStatement : public Stmt {
     assert(index < GetSize());
     return stmts_[index];
   }
-
-  void AddStmt(Stmt* stmt) { stmts_.push_back(stmt); }
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class ExpressionStatement : public Stmt {};
@@ -68,62 +75,65 @@ class IfStatement : public Stmt {
 
   IfStatement(SourceRange loc, Expr* condition, Stmt* then_stmt,
               Stmt* else_stmt)
-      : Stmt(std::move(loc)),
+      : Stmt(ASTNodeKind::IfStatement, loc),
         condition_(condition),
         then_stmt_(then_stmt),
         else_stmt_(else_stmt) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::IfStatement;
+  }
+
   static IfStatement* Create(ASTContext& ctx, SourceRange loc, Expr* condition,
                              Stmt* then_stmt, Stmt* else_stmt);
 
   Expr* GetCondition() { return condition_; }
   Stmt* GetThen() { return then_stmt_; }
   Stmt* GetElse() { return else_stmt_; }
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class CaseStatement : public Stmt {
   Stmt* stmt_ = nullptr;
-  std::optional<std::string> value_;
+  // The spelling of the case value, empty for default.
+  std::string_view value_;
 
-  std::string label_;
+  // Codegen numbers the labels of the cases.
+  std::int64_t label_ = -1;
   bool is_default_;
 
-  explicit CaseStatement(SourceRange loc, Stmt* stmt,
-                         std::optional<std::string> value, bool is_default)
-      : Stmt(std::move(loc)),
+  explicit CaseStatement(SourceRange loc, Stmt* stmt, std::string_view value,
+                         bool is_default)
+      : Stmt(ASTNodeKind::CaseStatement, loc),
         stmt_(stmt),
-        value_(std::move(value)),
+        value_(value),
         is_default_(is_default) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::CaseStatement;
+  }
+
   static CaseStatement* Create(ASTContext& ctx, SourceRange loc, Stmt* stmt,
-                               std::optional<std::string> value,
+                               std::string_view value,
                                bool is_default = false);
 
   Stmt* GetStmt() { return stmt_; }
 
-  [[nodiscard]] std::string GetValue() const {
-    assert(value_.has_value() && "Can't get value from a default statement!");
-    return *value_;
+  [[nodiscard]] std::string_view GetValue() const {
+    assert(!is_default_ && "Can't get value from a default statement!");
+    return value_;
   }
 
-  [[nodiscard]] std::string GetLabel() const {
-    assert(!label_.empty() &&
+  [[nodiscard]] std::int64_t GetLabel() const {
+    assert(label_ != -1 &&
            "The label of CaseStatement need to be set before use");
     return label_;
   }
 
-  void SetLabel(const std::string& label) { label_ = label; }
+  void SetLabel(std::int64_t label) { label_ = label; }
 
   [[nodiscard]] bool IsDefault() const { return is_default_; }
-
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class SwitchStatement : public Stmt {
@@ -132,9 +142,15 @@ class SwitchStatement : public Stmt {
 
   explicit SwitchStatement(SourceRange loc, Expr* condition,
                            CompoundStatement* body)
-      : Stmt(std::move(loc)), condition_(condition), body_(body) {}
+      : Stmt(ASTNodeKind::SwitchStatement, loc),
+        condition_(condition),
+        body_(body) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::SwitchStatement;
+  }
+
   static SwitchStatement* Create(ASTContext& ctx, SourceRange loc,
                                  Expr* condition, CompoundStatement* body);
 
@@ -144,9 +160,7 @@ class SwitchStatement : public Stmt {
 
   Expr* GetCondition() { return condition_; }
 
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
+  CompoundStatement* GetBody() { return body_; }
 };
 
 class WhileStatement : public Stmt {
@@ -154,16 +168,19 @@ class WhileStatement : public Stmt {
   Stmt* body_ = nullptr;
 
   explicit WhileStatement(SourceRange loc, Expr* condition, Stmt* body)
-      : Stmt(std::move(loc)), condition_(condition), body_(body) {}
+      : Stmt(ASTNodeKind::WhileStatement, loc),
+        condition_(condition),
+        body_(body) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::WhileStatement;
+  }
+
   static WhileStatement* Create(ASTContext& ctx, SourceRange loc,
                                 Expr* condition, Stmt* body);
   Expr* GetCondition() { return condition_; }
   Stmt* GetBody() { return body_; }
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class DoStatement : public Stmt {
@@ -171,17 +188,20 @@ class DoStatement : public Stmt {
   Stmt* body_ = nullptr;
 
   explicit DoStatement(SourceRange loc, Expr* condition, Stmt* body)
-      : Stmt(std::move(loc)), condition_(condition), body_(body) {}
+      : Stmt(ASTNodeKind::DoStatement, loc),
+        condition_(condition),
+        body_(body) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::DoStatement;
+  }
+
   static DoStatement* Create(ASTContext& ctx, SourceRange loc, Expr* condition,
                              Stmt* body);
 
   Stmt* GetBody() { return body_; }
   Expr* GetCondition() { return condition_; }
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class ForStatement : public Stmt {
@@ -192,13 +212,17 @@ class ForStatement : public Stmt {
 
   explicit ForStatement(SourceRange loc, Stmt* init, Stmt* condition,
                         Stmt* increment, Stmt* body)
-      : Stmt(std::move(loc)),
+      : Stmt(ASTNodeKind::ForStatement, loc),
         init_(init),
         condition_(condition),
         increment_(increment),
         body_(body) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::ForStatement;
+  }
+
   static ForStatement* Create(ASTContext& ctx, SourceRange loc, Stmt* init,
                               Stmt* condition, Stmt* increment, Stmt* body);
 
@@ -206,9 +230,6 @@ class ForStatement : public Stmt {
   Stmt* GetCondition() { return condition_; }
   Stmt* GetIncrement() { return increment_; }
   Stmt* GetBody() { return body_; }
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class GotoStatement : public Stmt {
@@ -216,70 +237,75 @@ class GotoStatement : public Stmt {
   SourceRange goto_loc_;
 
   GotoStatement(SourceRange loc, LabelDecl* label, SourceRange goto_loc)
-      : Stmt(std::move(loc)), label_(label), goto_loc_(std::move(goto_loc)) {}
+      : Stmt(ASTNodeKind::GotoStatement, loc),
+        label_(label),
+        goto_loc_(goto_loc) {}
 
  public:
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::GotoStatement;
+  }
 };
 
 class ContinueStatement : public Stmt {
   SourceRange continue_loc_;
 
   ContinueStatement(SourceRange loc, SourceRange continue_loc)
-      : Stmt(std::move(loc)), continue_loc_(std::move(continue_loc)) {}
+      : Stmt(ASTNodeKind::ContinueStatement, loc),
+        continue_loc_(continue_loc) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::ContinueStatement;
+  }
+
   static ContinueStatement* Create(ASTContext& ctx, SourceRange loc,
                                    SourceRange continue_loc);
-
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class BreakStatement : public Stmt {
   SourceRange break_loc_;
 
   BreakStatement(SourceRange loc, SourceRange break_loc)
-      : Stmt(std::move(loc)), break_loc_(std::move(break_loc)) {}
+      : Stmt(ASTNodeKind::BreakStatement, loc), break_loc_(break_loc) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::BreakStatement;
+  }
+
   static BreakStatement* Create(ASTContext& ctx, SourceRange loc,
                                 SourceRange break_loc);
-
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class ReturnStatement : public Stmt {
   Expr* return_expr_ = nullptr;
 
   ReturnStatement(SourceRange loc, Expr* return_expr)
-      : Stmt(std::move(loc)), return_expr_(return_expr) {}
+      : Stmt(ASTNodeKind::ReturnStatement, loc), return_expr_(return_expr) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::ReturnStatement;
+  }
+
   static ReturnStatement* Create(ASTContext& ctx, SourceRange loc,
                                  Expr* return_expr);
   Expr* GetReturn() { return return_expr_; }
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 
 class DeclStatement : public Stmt {
-  std::vector<Decl*> decls_;
-  DeclStatement(SourceRange loc, std::vector<Decl*> decls)
-      : Stmt(std::move(loc)), decls_(std::move(decls)) {}
-  DeclStatement(SourceRange loc, Decl* decl) : Stmt(std::move(loc)) {
-    decls_.emplace_back(decl);
-  }
+  std::span<Decl*> decls_;
+  DeclStatement(SourceRange loc, std::span<Decl*> decls)
+      : Stmt(ASTNodeKind::DeclStatement, loc), decls_(decls) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::DeclStatement;
+  }
+
   static DeclStatement* Create(ASTContext& ctx, SourceRange loc,
-                               std::vector<Decl*> decls);
+                               std::span<Decl* const> decls);
   static DeclStatement* Create(ASTContext& ctx, SourceRange loc, Decl* decl);
 
   [[nodiscard]] bool IsSingleDecl() const { return decls_.size() == 1; }
@@ -289,22 +315,20 @@ class DeclStatement : public Stmt {
     return decls_[0];
   }
 
-  std::vector<Decl*> GetDecls() { return decls_; }
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
+  [[nodiscard]] std::span<Decl*> GetDecls() const { return decls_; }
 };
 
 class ExprStatement : public Stmt {
   Expr* expr_;
   ExprStatement(SourceRange loc, Expr* expr)
-      : Stmt(std::move(loc)), expr_(expr) {}
+      : Stmt(ASTNodeKind::ExprStatement, loc), expr_(expr) {}
 
  public:
+  static bool classof(const ASTNode* node) {
+    return node->GetKind() == ASTNodeKind::ExprStatement;
+  }
+
   static ExprStatement* Create(ASTContext& ctx, SourceRange loc, Expr* expr);
   Expr* GetExpr() { return expr_; }
-  void dump(int indent) const override;
-
-  void GenCode(CodeGen& gen) override;
 };
 }  // namespace jcc
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 #include <string>
 #include <string_view>
 
@@ -9,6 +10,8 @@
 
 namespace jcc {
 
+class IdentifierInfo;
+
 enum class TokenKind {
   StringLiteral,
   NumericConstant,
@@ -125,21 +128,23 @@ enum class TokenKind {
 // debugging easier.
 class Token {
   TokenKind kind_ = TokenKind::Unspecified;
-  // I'm not sure if we need to do more for identifiers,
-  // if so, we can use a variant.
+
+  std::uint32_t length_ = 0;
+
   const char* data_ = nullptr;
 
-  std::size_t length_ = 0;
+  // The interned spelling of identifiers and keywords, null otherwise.
+  IdentifierInfo* ident_ = nullptr;
 
   SourceLocation loc_;
 
  public:
-  using TokenSize = std::size_t;
+  using TokenSize = std::uint32_t;
 
   Token() = default;
-  Token(TokenKind kind, const char* data, std::size_t len,
-        const SourceLocation& loc)
-      : kind_(kind), data_(data), length_(len), loc_(loc) {}
+  Token(TokenKind kind, const char* data, TokenSize len,
+        const SourceLocation& loc, IdentifierInfo* ident = nullptr)
+      : kind_(kind), length_(len), data_(data), ident_(ident), loc_(loc) {}
 
   [[nodiscard]] TokenKind GetKind() const { return kind_; }
 
@@ -161,6 +166,8 @@ class Token {
 
   [[nodiscard]] bool IsValid() const { return kind_ != TokenKind::Unspecified; }
 
+  [[nodiscard]] IdentifierInfo* GetIdentifierInfo() const { return ident_; }
+
   [[nodiscard]] std::string_view GetStrView() const {
     assert(getLength() != 0 &&
            "Cannot get value from tokens that have no value!");
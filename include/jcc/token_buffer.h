@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "jcc/allocator.h"
+#include "jcc/source_location.h"
+#include "jcc/token.h"
+
+namespace jcc {
+
+class IdentifierInfo;
+
+// The tokens of a whole file, stored as parallel arrays rather than as
+// Tokens: the parser mostly looks at kinds, which this keeps densely packed.
+// Offsets are relative to the start of the file, so a token's spelling is
+// `buffer_start + offset` and its location `file_loc + offset`.
+//
+// The last token is always Eof.
+class TokenBuffer {
+  const char* buffer_start_;
+  SourceLocation file_loc_;
+
+  // Owns the arrays below, those of any sizable file take its large
+  // allocation path. Outgrown arrays stay in it until the buffer goes away,
+  // which costs at most as much as the final ones as they grow by doubling.
+  // Held by pointer as an Arena can't be moved, but a TokenBuffer can.
+  std::unique_ptr<Arena> arena_ = std::make_unique<Arena>();
+  TokenKind* kinds_ = nullptr;
+  std::uint32_t* offsets_ = nullptr;
+  Token::TokenSize* lengths_ = nullptr;
+  // Identifiers and keywords come interned, keep them so the parser doesn't
+  // need to look them up again. Null for every other kind.
+  IdentifierInfo** idents_ = nullptr;
+  std::size_t size_ = 0;
+  std::size_t capacity_ = 0;
+
+  template <typename T>
+  T* Grow(const T* old, std::size_t capacity) {
+    auto* data = static_cast<T*>(arena_->AllocateAligned(sizeof(T) * capacity));
+    std::copy_n(old, size_, data);
+    return data;
+  }
+
+ public:
+  TokenBuffer(const char* buffer_start, SourceLocation file_loc)
+      : buffer_start_(buffer_start), file_loc_(file_loc) {}
+
+  void Reserve(std::size_t capacity) {
+    if (capacity <= capacity_) {
+      return;
+    }
+    kinds_ = Grow(kinds_, capacity);
+    offsets_ = Grow(offsets_, capacity);
+    lengths_ = Grow(lengths_, capacity);
+    idents_ = Grow(idents_, capacity);
+    capacity_ = capacity;
+  }
+
+  void Push(const Token& token) {
+    if (size_ == capacity_) {
+      Reserve(std::max<std::size_t>(capacity_ * 2, 64));
+    }
+    kinds_[size_] = token.GetKind();
+    offsets_[size_] =
+        static_cast<std::uint32_t>(token.GetData() - buffer_start_);
+    lengths_[size_] = token.getLength();
+    idents_[size_] = token.GetIdentifierInfo();
+    size_++;
+  }
+
+  [[nodiscard]] std::size_t GetSize() const { return size_; }
+
+  [[nodiscard]] TokenKind GetKind(std::size_t index) const {
+    return kinds_[index];
+  }
+
+  [[nodiscard]] SourceLocation GetLocation(std::size_t index) const {
+    return file_loc_.GetLocWithOffset(offsets_[index]);
+  }
+
+  [[nodiscard]] Token GetToken(std::size_t index) const {
+    assert(index < GetSize() && "Token index out of range!");
+    return {kinds_[index], buffer_start_ + offsets_[index], lengths_[index],
+            GetLocation(index), idents_[index]};
+  }
+};
+}  // namespace jcc
@@ -1,19 +1,15 @@
 #pragma once
 
+#include <cassert>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
-#include <string>
-#include <string_view>
-#include <vector>
-
-#include "fmt/format.h"
-#include "jcc/common.h"
-#include "jcc/token.h"
+#include <span>
 
 namespace jcc {
 
 class ASTContext;
+class IdentifierInfo;
 
 enum class Qualifiers : uint8_t {
   Unspecified = 0,
@@ -23,7 +19,7 @@ enum class Qualifiers : uint8_t {
   Atomic = 4
 };
 
-enum class TypeKind {
+enum class TypeKind : std::uint8_t {
   Void,
   Bool,
   Char,
@@ -42,33 +38,39 @@ enum class TypeKind {
   Union
 };
 
+// Types are looked at for nearly every expression during codegen, so they
+// are kept small: the kind, qualifiers and flags share one 32-bit word, and
+// sizes are 32 bits. Builtin types are statically allocated and shared by
+// every ASTContext, derived types are uniqued by it.
 class Type {
   TypeKind kind_;
   Qualifiers quals_ = Qualifiers::Unspecified;
-  bool is_static_ = false;
+  bool unsigned_ : 1 = false;
+  bool is_static_ : 1 = false;
 
-  Token name_;
+  std::uint32_t size_ = 0;
+  std::uint32_t alignment_ = 0;
 
-  size_t size_ = 0;
-  size_t alignment_ = 0;
-  bool unsigned_ = false;
+  // The tag of structs, unions and enums.
+  IdentifierInfo* name_ = nullptr;
 
   Type* origin_ = nullptr;
 
  public:
   Type() = default;
-  virtual ~Type();
 
-  explicit Type(TypeKind kind, size_t size, size_t alignment)
-      : kind_(kind), size_(size), alignment_(alignment) {}
+  constexpr Type(TypeKind kind, std::uint32_t size, std::uint32_t alignment,
+                 bool is_unsigned = false)
+      : kind_(kind),
+        unsigned_(is_unsigned),
+        size_(size),
+        alignment_(alignment) {}
 
   template <typename Ty>
   requires std::convertible_to<Ty, Type> Ty* AsType() {
     return static_cast<Ty*>(this);
   }
 
-  virtual void dump(int indent) const { fmt::print("{}\n", GetNameAsString()); }
-
   [[nodiscard]] bool HasQualifiers() const {
     return quals_ != Qualifiers::Unspecified;
   }
@@ -120,25 +122,25 @@ class Type {
 
   [[nodiscard]] bool IsPointer() const { return this->Is<TypeKind::Ptr>(); }
 
-  void SetName(const Token& name) { name_ = name; }
+  // The unqualified type this one was derived from, or itself.
+  [[nodiscard]] const Type* GetOrigin() const {
+    return origin_ != nullptr ? origin_ : this;
+  }
 
-  Token GetName() { return name_; }
+  void SetName(IdentifierInfo* name) { name_ = name; }
 
-  void SetSizeAlign(size_t size, size_t alignment) {
+  [[nodiscard]] IdentifierInfo* GetName() const { return name_; }
+
+  void SetSizeAlign(std::uint32_t size, std::uint32_t alignment) {
     size_ = size;
     alignment_ = alignment;
   }
 
   void SetUnsigned(bool usg = true) { unsigned_ = usg; }
 
-  [[nodiscard]] std::string GetNameAsString() const {
-    assert(name_.IsValid() && "Can't access name of non-user-defined types!");
-    return name_.GetAsString();
-  }
-
   [[nodiscard]] std::size_t GetSize() const { return size_; }
 
-  [[nodiscard]] size_t GetAlignment() const { return alignment_; }
+  [[nodiscard]] std::size_t GetAlignment() const { return alignment_; }
 
   [[nodiscard]] bool IsUnsigned() const { return unsigned_; }
 
@@ -146,29 +148,18 @@ class Type {
 
   static Type* CreateEnumType(ASTContext& ctx);
 
-  static Type* CreateVoidType(ASTContext& ctx);
-
-  static Type* CreateBoolType(ASTContext& ctx);
-
-  static Type* CreateCharType(ASTContext& ctx, bool is_unsigned);
-
-  static Type* CreateShortType(ASTContext& ctx, bool is_unsigned);
-
-  static Type* CreateIntType(ASTContext& ctx, bool is_unsigned);
-
-  static Type* CreateLongType(ASTContext& ctx, bool is_unsigned);
-
-  static Type* CreateFloatType(ASTContext& ctx);
-
-  static Type* CreateDoubleType(ASTContext& ctx, bool is_long);
-
-  static Type* CreateFuncType(ASTContext& ctx, Type* return_type);
+  static Type* CreateFuncType(ASTContext& ctx, Type* return_type,
+                              std::span<Type* const> params);
 
   static Type* CreateArrayType(ASTContext& ctx, Type* base, std::size_t len);
 
   // struct or union.
   static Type* CreateRecordType(ASTContext& ctx, TypeKind kind);
 
+  // Copies a builtin type and attaches qualifiers and storage to the copy.
+  static Type* CreateQualifiedType(ASTContext& ctx, Type* base,
+                                   Qualifiers quals, bool is_static);
+
   static bool IsCompatible(const Type& lhs, const Type& rhs);
 };
 
@@ -178,9 +169,8 @@ class ArrayType : public Type {
 
  public:
   ArrayType() = default;
-  ~ArrayType() override;
 
-  ArrayType(TypeKind kind, std::size_t size, size_t alignment)
+  ArrayType(TypeKind kind, std::uint32_t size, std::uint32_t alignment)
       : Type(kind, size, alignment) {}
 
   [[nodiscard]] std::size_t GetLength() const { return len_; }
@@ -197,9 +187,8 @@ class PointerType : public Type {
 
  public:
   PointerType() = default;
-  ~PointerType() override;
 
-  PointerType(TypeKind kind, size_t size, size_t alignment)
+  PointerType(TypeKind kind, std::uint32_t size, std::uint32_t alignment)
       : Type(kind, size, alignment) {}
 
   Type* GetBase() { return base_; }
@@ -208,14 +197,14 @@ class PointerType : public Type {
 };
 
 class RecordType : public Type {
-  std::vector<Type*> members_;
+  // Owned by the ASTContext.
+  std::span<Type*> members_;
 
  public:
-  RecordType(TypeKind kind, size_t size, size_t alignment)
+  RecordType(TypeKind kind, std::uint32_t size, std::uint32_t alignment)
       : Type(kind, size, alignment) {}
-  ~RecordType() override;
 
-  void SetMembers(const std::vector<Type*>& members) { members_ = members; }
+  void SetMembers(std::span<Type*> members) { members_ = members; }
 
   [[nodiscard]] std::size_t GetMemberSize() const { return members_.size(); }
 
@@ -224,13 +213,13 @@ class RecordType : public Type {
 
 class FunctionType : public Type {
   Type* return_type_;
-  std::vector<Type*> param_types_;
+  // Owned by the ASTContext.
+  std::span<Type*> param_types_;
 
  public:
   FunctionType() = default;
-  ~FunctionType() override;
 
-  FunctionType(TypeKind kind, size_t size, size_t alignment)
+  FunctionType(TypeKind kind, std::uint32_t size, std::uint32_t alignment)
       : Type(kind, size, alignment) {}
 
   Type* GetReturnType() { return return_type_; }
@@ -242,9 +231,9 @@ class FunctionType : public Type {
     return param_types_[idx];
   }
 
-  void SetParams(std::vector<Type*> params) {
-    param_types_ = std::move(params);
-  }
+  void SetParams(std::span<Type*> params) { param_types_ = params; }
+
+  [[nodiscard]] std::span<Type*> GetParams() const { return param_types_; }
 
   [[nodiscard]] std::size_t GetParamSize() const { return param_types_.size(); }
 };
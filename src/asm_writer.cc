@@ -0,0 +1,195 @@
+#include "jcc/asm_writer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "jcc/assembler.h"
+
+namespace jcc {
+
+// Text is written in pieces of at least this much, to keep the number of
+// system calls down.
+static constexpr std::size_t min_text_write = 64 * 1024;
+
+[[noreturn]] static void Fail(std::string_view what) {
+  fmt::print(stderr, "Failed to {} the output: {}!\n", what,
+             std::strerror(errno));
+  std::exit(-1);
+}
+
+static bool WriteAll(int fd, const char* data, std::size_t size) {
+  while (size != 0) {
+    ssize_t written = write(fd, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= static_cast<std::size_t>(written);
+  }
+  return true;
+}
+
+// Appends the first `size` bytes of `in` to `out`. The kernel copies them
+// itself where it can, with copy_file_range between files, which may
+// even share the blocks, or splice into a pipe.
+static bool CopyFile(int in, int out, std::size_t size) {
+  loff_t offset = 0;
+  while (offset < static_cast<loff_t>(size)) {
+    const auto left = size - static_cast<std::size_t>(offset);
+    ssize_t copied = copy_file_range(in, &offset, out, nullptr, left, 0);
+    if (copied < 0) {
+      copied = splice(in, &offset, out, nullptr, left, 0);
+    }
+    if (copied < 0) {
+      break;
+    }
+    if (copied == 0) {
+      return false;
+    }
+  }
+  // Neither works here, copy through user space.
+  char buffer[64 * 1024];
+  while (offset < static_cast<loff_t>(size)) {
+    const auto left = size - static_cast<std::size_t>(offset);
+    ssize_t count = pread(in, buffer, std::min(left, sizeof(buffer)), offset);
+    if (count <= 0 ||
+        !WriteAll(out, buffer, static_cast<std::size_t>(count))) {
+      return false;
+    }
+    offset += count;
+  }
+  return true;
+}
+
+// Not every file system supports O_TMPFILE, fall back to a named file
+// which is unlinked right away.
+static int CreateSpillFile(const std::string& dir) {
+  int fd = open(dir.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+  if (fd >= 0) {
+    return fd;
+  }
+  std::string path = dir + "/jcc-data-XXXXXX";
+  fd = mkostemp(path.data(), O_CLOEXEC);
+  if (fd >= 0) {
+    unlink(path.c_str());
+  }
+  return fd;
+}
+
+void AsmBuffer::VFormat(fmt::string_view format, fmt::format_args args) {
+  const auto available = static_cast<std::size_t>(end_ - cur_);
+  auto result = fmt::vformat_to_n(cur_, available, format, args);
+  if (result.size > available) {
+    // Didn't fit, format it again at the start of a new chunk.
+    NewChunk(result.size);
+    fmt::vformat_to(cur_, format, args);
+  }
+  cur_ += result.size;
+}
+
+std::size_t AsmBuffer::GetSize() const {
+  std::size_t size = 0;
+  for (const Chunk& chunk : chunks_) {
+    size += GetChunkSize(chunk);
+  }
+  return size;
+}
+
+bool AsmBuffer::Drain(int fd) {
+  return Drain([fd](std::string_view text) {
+    return WriteAll(fd, text.data(), text.size());
+  });
+}
+
+void AsmBuffer::Clear() {
+  if (chunks_.empty()) {
+    return;
+  }
+  chunks_.resize(1);
+  cur_ = chunks_.front().data.get();
+  end_ = cur_ + chunks_.front().capacity;
+}
+
+void AsmBuffer::NewChunk(std::size_t size) {
+  if (!chunks_.empty()) {
+    chunks_.back().size = GetChunkSize(chunks_.back());
+  }
+  size = std::max(size, chunk_size);
+  chunks_.push_back({std::make_unique_for_overwrite<char[]>(size), size, 0});
+  cur_ = chunks_.back().data.get();
+  end_ = cur_ + size;
+}
+
+AsmWriter::~AsmWriter() {
+  if (spill_fd_ >= 0) {
+    close(spill_fd_);
+  }
+}
+
+void AsmWriter::Flush() {
+  if (assembler_ != nullptr) {
+    // The assembler keeps the data, which is a lot smaller than its text.
+    if (text_.GetSize() >= min_text_write) {
+      AssembleText();
+    }
+    return;
+  }
+  if (text_.GetSize() >= min_text_write) {
+    WriteText();
+  }
+  if (data_.GetSize() >= max_buffered_data) {
+    SpillData();
+  }
+}
+
+void AsmWriter::Finish() {
+  if (assembler_ != nullptr) {
+    AssembleText();
+    return;
+  }
+  WriteText();
+  if (spill_fd_ >= 0 && !CopyFile(spill_fd_, fd_, spilled_)) {
+    Fail("write");
+  }
+  if (!data_.Drain(fd_)) {
+    Fail("write");
+  }
+}
+
+void AsmWriter::WriteText() {
+  if (!header_.Drain(fd_) || !text_.Drain(fd_)) {
+    Fail("write");
+  }
+}
+
+void AsmWriter::AssembleText() {
+  auto assemble = [this](std::string_view text) {
+    assembler_->Assemble(text);
+    return true;
+  };
+  header_.Drain(assemble);
+  data_.Drain(assemble);
+  text_.Drain(assemble);
+}
+
+void AsmWriter::SpillData() {
+  if (spill_fd_ < 0) {
+    spill_fd_ = CreateSpillFile(spill_dir_);
+    if (spill_fd_ < 0) {
+      Fail("spill");
+    }
+  }
+  spilled_ += data_.GetSize();
+  if (!data_.Drain(spill_fd_)) {
+    Fail("spill");
+  }
+}
+}  // namespace jcc
@@ -0,0 +1,789 @@
+#include "jcc/assembler.h"
+
+#include <elf.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "jcc/common.h"
+
+namespace jcc {
+
+// The base of a memory operand addressing relative to the next instruction.
+static constexpr int rip = 16;
+
+struct Operand {
+  enum class Kind { Register, Immediate, Memory, Symbol };
+
+  Kind kind;
+  // `*%r10` or `*(%rax)`, the target of an indirect call or jump.
+  bool indirect = false;
+  // The register, or the base of a memory operand.
+  int reg = 0;
+  // Of a register, in bytes.
+  int size = 0;
+  // An immediate, or the displacement of a memory operand.
+  std::int64_t value = 0;
+  // What a branch or a memory operand refers to.
+  std::string_view symbol;
+  // The symbol stands for its GOT entry.
+  bool got = false;
+};
+
+// A value for the reg field of ModRM which extends the opcode.
+static Operand Digit(int digit) {
+  Operand operand;
+  operand.kind = Operand::Kind::Register;
+  operand.reg = digit;
+  return operand;
+}
+
+static bool IsInt8(std::int64_t value) {
+  return value >= std::numeric_limits<std::int8_t>::min() &&
+         value <= std::numeric_limits<std::int8_t>::max();
+}
+
+static bool IsInt32(std::int64_t value) {
+  return value >= std::numeric_limits<std::int32_t>::min() &&
+         value <= std::numeric_limits<std::int32_t>::max();
+}
+
+static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Hand-rolled, find_first_not_of() calls memchr() for every character.
+static std::string_view Trim(std::string_view text) {
+  while (!text.empty() && IsSpace(text.front())) {
+    text.remove_prefix(1);
+  }
+  while (!text.empty() && IsSpace(text.back())) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+template <typename T>
+static bool ParseNumber(std::string_view text, T& value) {
+  auto [ptr, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  return error == std::errc() && ptr == text.data() + text.size();
+}
+
+// Splits "a, b" into its trimmed parts.
+static std::pair<std::string_view, std::string_view> SplitComma(
+    std::string_view text) {
+  const std::size_t comma = text.find(',');
+  if (comma == std::string_view::npos) {
+    return {Trim(text), {}};
+  }
+  return {Trim(text.substr(0, comma)), Trim(text.substr(comma + 1))};
+}
+
+// Symbols of the form .L* are the assembler's own, they're never written to
+// the symbol table.
+static bool IsTemporary(std::string_view name) {
+  return name.starts_with(".L");
+}
+
+// Decodes the name of a general purpose register, without the `%`. This is
+// done for most operands, so it's spelled out rather than looked up.
+static bool GetRegister(std::string_view name, Operand& operand) {
+  operand.kind = Operand::Kind::Register;
+  // r8 to r15, with a suffix for the lower parts.
+  if (name.size() >= 2 && name[0] == 'r' && name[1] >= '0' && name[1] <= '9') {
+    const std::size_t digits =
+        name.size() >= 3 && name[2] >= '0' && name[2] <= '9' ? 3 : 2;
+    if (!ParseNumber(name.substr(1, digits - 1), operand.reg) ||
+        operand.reg < 8 || operand.reg > 15) {
+      return false;
+    }
+    if (name.size() == digits) {
+      operand.size = 8;
+      return true;
+    }
+    if (name.size() != digits + 1) {
+      return false;
+    }
+    switch (name.back()) {
+      case 'd':
+        operand.size = 4;
+        return true;
+      case 'w':
+        operand.size = 2;
+        return true;
+      case 'b':
+        operand.size = 1;
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  // The rest are named after the 16-bit ones, with a prefix for the wider
+  // ones: rax, eax and ax. The byte ones are al, cl, dl and bl, then spl,
+  // bpl, sil and dil.
+  static constexpr char legacy[8][2] = {{'a', 'x'}, {'c', 'x'}, {'d', 'x'},
+                                        {'b', 'x'}, {'s', 'p'}, {'b', 'p'},
+                                        {'s', 'i'}, {'d', 'i'}};
+  char base[2];
+  if (name.size() == 3 && (name[0] == 'r' || name[0] == 'e')) {
+    operand.size = name[0] == 'r' ? 8 : 4;
+    base[0] = name[1];
+    base[1] = name[2];
+  } else if (name.size() == 2 && name[1] == 'l') {
+    operand.size = 1;
+    base[0] = name[0];
+    base[1] = 'x';
+  } else if (name.size() == 3 && name[2] == 'l') {
+    operand.size = 1;
+    base[0] = name[0];
+    base[1] = name[1];
+  } else if (name.size() == 2) {
+    operand.size = 2;
+    base[0] = name[0];
+    base[1] = name[1];
+  } else {
+    return false;
+  }
+  for (int reg = 0; reg < 8; reg++) {
+    if (base[0] == legacy[reg][0] && base[1] == legacy[reg][1]) {
+      operand.reg = reg;
+      // Not axl or sl.
+      return operand.size != 1 || (reg < 4) == (name.size() == 2);
+    }
+  }
+  return false;
+}
+
+namespace {
+
+struct Mnemonic {
+  enum class Kind {
+    Ret,
+    Push,
+    Pop,
+    Call,
+    Jmp,
+    Jcc,
+    Setcc,
+    Movsxd,
+    // movzbl, movswq and the like.
+    Extend,
+    Mov,
+    Lea,
+    // add, sub, cmp and the others sharing their encodings.
+    Arith,
+  };
+
+  Kind kind;
+  // The condition code of jcc and setcc, the opcode extension of Arith, or
+  // whether Extend zero extends.
+  int code = 0;
+  // The operand size a suffix like the `l` of `addl` stands for, 0 if
+  // there's no suffix.
+  int size = 0;
+  // The size Extend extends from.
+  int src_size = 0;
+};
+
+}  // namespace
+
+// Mnemonics are short enough to be compared as integers, which is a lot
+// cheaper than hashing them. 0 if `name` is too long to be one.
+static std::uint64_t Pack(std::string_view name) {
+  std::uint64_t packed = 0;
+  if (name.size() > sizeof(packed)) {
+    return 0;
+  }
+  std::memcpy(&packed, name.data(), name.size());
+  return packed;
+}
+
+// Every spelling of every instruction known, looked up once per line.
+static const Mnemonic* GetMnemonic(std::string_view name) {
+  using enum Mnemonic::Kind;
+  static const auto mnemonics = [] {
+    static constexpr std::pair<std::string_view, int> conditions[] = {
+        {"o", 0},   {"no", 1},  {"b", 2},   {"c", 2},   {"nae", 2},
+        {"ae", 3},  {"nb", 3},  {"nc", 3},  {"e", 4},   {"z", 4},
+        {"ne", 5},  {"nz", 5},  {"be", 6},  {"na", 6},  {"a", 7},
+        {"nbe", 7}, {"s", 8},   {"ns", 9},  {"p", 10},  {"pe", 10},
+        {"np", 11}, {"po", 11}, {"l", 12},  {"nge", 12}, {"ge", 13},
+        {"nl", 13}, {"le", 14}, {"ng", 14}, {"g", 15},  {"nle", 15}};
+    static constexpr std::string_view arith[] = {"add", "or",  "adc", "sbb",
+                                                 "and", "sub", "xor", "cmp"};
+    static constexpr std::pair<char, int> suffixes[] = {
+        {'b', 1}, {'w', 2}, {'l', 4}, {'q', 8}};
+
+    std::vector<std::pair<std::string, Mnemonic>> spellings = {
+        {"ret", {Ret}},       {"push", {Push}},     {"pushq", {Push}},
+        {"pop", {Pop}},       {"popq", {Pop}},      {"call", {Call}},
+        {"jmp", {Jmp}},       {"movsxd", {Movsxd}}, {"movslq", {Movsxd}},
+        {"lea", {Lea}},       {"mov", {Mov}}};
+    for (auto [condition, code] : conditions) {
+      spellings.push_back({"j" + std::string(condition), {Jcc, code}});
+      spellings.push_back({"set" + std::string(condition), {Setcc, code}});
+    }
+    for (int op = 0; op < 8; op++) {
+      spellings.push_back({std::string(arith[op]), {Arith, op}});
+    }
+    for (auto [suffix, size] : suffixes) {
+      spellings.push_back({std::string("lea") + suffix, {Lea, 0, size}});
+      spellings.push_back({std::string("mov") + suffix, {Mov, 0, size}});
+      for (int op = 0; op < 8; op++) {
+        spellings.push_back(
+            {std::string(arith[op]) + suffix, {Arith, op, size}});
+      }
+    }
+    for (int zero = 0; zero < 2; zero++) {
+      for (auto [src_suffix, src_size] : {suffixes[0], suffixes[1]}) {
+        const std::string extend =
+            std::string(zero ? "movz" : "movs") + src_suffix;
+        spellings.push_back({extend, {Extend, zero, 0, src_size}});
+        for (auto [suffix, size] : suffixes) {
+          if (size > src_size) {
+            spellings.push_back(
+                {extend + suffix, {Extend, zero, size, src_size}});
+          }
+        }
+      }
+    }
+    std::vector<std::pair<std::uint64_t, Mnemonic>> mnemonics;
+    for (const auto& [spelling, mnemonic] : spellings) {
+      mnemonics.emplace_back(Pack(spelling), mnemonic);
+    }
+    std::ranges::sort(mnemonics, {}, [](const auto& m) { return m.first; });
+    return mnemonics;
+  }();
+
+  const std::uint64_t packed = Pack(name);
+  auto iter = std::ranges::lower_bound(mnemonics, packed, {},
+                                       [](const auto& m) { return m.first; });
+  if (packed == 0 || iter == mnemonics.end() || iter->first != packed) {
+    return nullptr;
+  }
+  return &iter->second;
+}
+
+void Assembler::Assemble(std::string_view text) {
+  if (!partial_line_.empty()) {
+    const std::size_t newline = text.find('\n');
+    if (newline == std::string_view::npos) {
+      partial_line_ += text;
+      return;
+    }
+    partial_line_ += text.substr(0, newline);
+    AssembleLine(partial_line_);
+    partial_line_.clear();
+    text.remove_prefix(newline + 1);
+  }
+  for (std::size_t newline = text.find('\n');
+       newline != std::string_view::npos; newline = text.find('\n')) {
+    AssembleLine(text.substr(0, newline));
+    text.remove_prefix(newline + 1);
+  }
+  partial_line_ = text;
+}
+
+ObjectFile Assembler::Finish() {
+  if (!partial_line_.empty()) {
+    AssembleLine(partial_line_);
+    partial_line_.clear();
+  }
+
+  ObjectFile object;
+  object.sections.push_back({".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR,
+                             alignments_[Text], std::move(sections_[Text]),
+                             /*relocations=*/{}});
+  object.sections.push_back({".data", SHT_PROGBITS, SHF_ALLOC | SHF_WRITE,
+                             alignments_[Data], std::move(sections_[Data]),
+                             /*relocations=*/{}});
+  // The stack needn't be executable.
+  object.sections.push_back({".note.GNU-stack", SHT_PROGBITS, /*flags=*/0,
+                             /*alignment=*/1, /*data=*/"",
+                             /*relocations=*/{}});
+
+  if (!file_name_.empty()) {
+    object.symbols.push_back(
+        {file_name_, SHN_ABS, 0, 0, STB_LOCAL, STT_FILE});
+  }
+  // Temporary symbols are referred to relative to their sections.
+  std::size_t section_symbols[NumSections];
+  for (int i = 0; i < NumSections; i++) {
+    section_symbols[i] = object.symbols.size();
+    object.symbols.push_back(
+        {"", static_cast<std::uint16_t>(i + 1), 0, 0, STB_LOCAL, STT_SECTION});
+  }
+  for (Symbol& symbol : symbols_) {
+    const bool defined = symbol.section != NumSections;
+    if (IsTemporary(symbol.name)) {
+      if (!defined) {
+        jcc_unreachable(fmt::format("Undefined label {}!", symbol.name));
+      }
+      continue;
+    }
+    symbol.object_index = object.symbols.size();
+    object.symbols.push_back(
+        {symbol.name,
+         static_cast<std::uint16_t>(defined ? symbol.section + 1 : SHN_UNDEF),
+         symbol.value, symbol.size,
+         static_cast<unsigned char>(symbol.global || !defined ? STB_GLOBAL
+                                                              : STB_LOCAL),
+         symbol.type});
+  }
+
+  for (const Fixup& fixup : fixups_) {
+    const Symbol& symbol = symbols_[fixup.symbol];
+    ObjectSection& section = object.sections[fixup.section];
+    // Branches within a section and references to its local symbols don't
+    // need the linker. Global symbols may be interposed, so they do.
+    if (fixup.type != R_X86_64_GOTPCREL && symbol.section == fixup.section &&
+        !symbol.global) {
+      const std::int64_t value =
+          static_cast<std::int64_t>(symbol.value - fixup.offset) +
+          fixup.addend;
+      if (!IsInt32(value)) {
+        jcc_unreachable(fmt::format("{} is out of range!", symbol.name));
+      }
+      for (int i = 0; i < 4; i++) {
+        section.data[fixup.offset + i] = static_cast<char>(value >> (i * 8));
+      }
+      continue;
+    }
+    if (IsTemporary(symbol.name)) {
+      if (fixup.type == R_X86_64_GOTPCREL) {
+        jcc_unreachable(
+            fmt::format("{} is temporary, it has no GOT entry!", symbol.name));
+      }
+      section.relocations.push_back(
+          {fixup.offset, section_symbols[symbol.section], fixup.type,
+           fixup.addend + static_cast<std::int64_t>(symbol.value)});
+    } else {
+      section.relocations.push_back(
+          {fixup.offset, symbol.object_index, fixup.type, fixup.addend});
+    }
+  }
+  return object;
+}
+
+void Assembler::AssembleLine(std::string_view line) {
+  line_ = line;
+  line = Trim(line);
+  if (line.empty() || line.front() == '#') {
+    return;
+  }
+  if (line.back() == ':') {
+    DefineLabel(line.substr(0, line.size() - 1));
+    return;
+  }
+  std::size_t space = 0;
+  while (space < line.size() && !IsSpace(line[space])) {
+    space++;
+  }
+  std::string_view name = line.substr(0, space);
+  std::string_view rest = Trim(line.substr(space));
+  if (name.front() == '.') {
+    AssembleDirective(name, rest);
+  } else {
+    AssembleInstr(name, rest);
+  }
+}
+
+void Assembler::AssembleDirective(std::string_view name,
+                                  std::string_view args) {
+  if (name == ".text") {
+    cur_ = Text;
+  } else if (name == ".data") {
+    cur_ = Data;
+  } else if (name == ".file") {
+    if (args.size() < 2 || args.front() != '"' || args.back() != '"') {
+      Error("expected a quoted file name");
+    }
+    file_name_ = args.substr(1, args.size() - 2);
+  } else if (name == ".globl" || name == ".global") {
+    symbols_[GetSymbol(args)].global = true;
+  } else if (name == ".local") {
+    symbols_[GetSymbol(args)].global = false;
+  } else if (name == ".type") {
+    auto [symbol, type] = SplitComma(args);
+    if (type == "@function") {
+      symbols_[GetSymbol(symbol)].type = STT_FUNC;
+    } else if (type == "@object") {
+      symbols_[GetSymbol(symbol)].type = STT_OBJECT;
+    } else {
+      Error("unknown symbol type");
+    }
+  } else if (name == ".size") {
+    auto [symbol, size_text] = SplitComma(args);
+    std::uint64_t size;
+    if (!ParseNumber(size_text, size)) {
+      Error("expected a size");
+    }
+    symbols_[GetSymbol(symbol)].size = size;
+  } else if (name == ".align") {
+    std::uint64_t align;
+    if (!ParseNumber(args, align) || align == 0 || (align & (align - 1))) {
+      Error("expected a power of two");
+    }
+    // Code is padded with nops, which never run anyway.
+    const char padding = cur_ == Text ? '\x90' : '\0';
+    Out().resize((Out().size() + align - 1) / align * align, padding);
+    alignments_[cur_] = std::max(alignments_[cur_], align);
+  } else if (name == ".byte") {
+    while (!args.empty()) {
+      auto [byte_text, rest] = SplitComma(args);
+      int byte;
+      if (!ParseNumber(byte_text, byte)) {
+        Error("expected a byte");
+      }
+      Emit(static_cast<std::uint8_t>(byte));
+      args = rest;
+    }
+  } else {
+    Error("unknown directive");
+  }
+}
+
+void Assembler::AssembleInstr(std::string_view mnemonic,
+                              std::string_view operands_text) {
+  Operand operands[3];
+  int num_operands = 0;
+  while (!operands_text.empty()) {
+    if (num_operands == 3) {
+      Error("too many operands");
+    }
+    // Commas only separate operands, there are no index registers.
+    auto [text, rest] = SplitComma(operands_text);
+    operands_text = rest;
+    Operand& operand = operands[num_operands++];
+    if (text.starts_with('*')) {
+      operand.indirect = true;
+      text = Trim(text.substr(1));
+    }
+    if (text.starts_with('%')) {
+      if (!GetRegister(text.substr(1), operand)) {
+        Error("unknown register");
+      }
+    } else if (text.starts_with('$')) {
+      operand.kind = Operand::Kind::Immediate;
+      if (!ParseNumber(text.substr(1), operand.value)) {
+        Error("expected a number");
+      }
+    } else if (const std::size_t paren = text.find('(');
+               paren != std::string_view::npos) {
+      operand.kind = Operand::Kind::Memory;
+      std::string_view base = text.substr(paren + 1);
+      if (!base.starts_with('%') || !base.ends_with(')')) {
+        Error("expected a base register");
+      }
+      base = base.substr(1, base.size() - 2);
+      Operand base_reg;
+      if (base == "rip") {
+        operand.reg = rip;
+      } else if (GetRegister(base, base_reg) && base_reg.size == 8) {
+        operand.reg = base_reg.reg;
+      } else {
+        Error("expected a 64-bit base register");
+      }
+      std::string_view disp = text.substr(0, paren);
+      if (disp.ends_with("@GOTPCREL")) {
+        operand.got = true;
+        disp.remove_suffix(9);
+      }
+      if (!disp.empty() && !ParseNumber(disp, operand.value)) {
+        operand.symbol = disp;
+      }
+      if (!operand.symbol.empty() && operand.reg != rip) {
+        Error("symbols are only addressed relative to %rip");
+      }
+    } else {
+      operand.kind = Operand::Kind::Symbol;
+      operand.symbol = text;
+    }
+  }
+
+  using enum Operand::Kind;
+  auto expect = [&](std::initializer_list<Operand::Kind> kinds) {
+    if (static_cast<std::size_t>(num_operands) != kinds.size() ||
+        !std::equal(kinds.begin(), kinds.end(), operands,
+                    [](Operand::Kind kind, const Operand& operand) {
+                      return kind == operand.kind;
+                    })) {
+      Error("unexpected operands");
+    }
+  };
+  Operand& src = operands[0];
+  Operand& dst = operands[num_operands == 2 ? 1 : 0];
+
+  const Mnemonic* info = GetMnemonic(mnemonic);
+  if (info == nullptr) {
+    Error("unknown instruction");
+  }
+  // Instructions without an operand size first.
+  switch (info->kind) {
+    case Mnemonic::Kind::Ret:
+      expect({});
+      Emit(0xc3);
+      return;
+    case Mnemonic::Kind::Push:
+    case Mnemonic::Kind::Pop:
+      expect({Register});
+      if (src.size != 8) {
+        Error("expected a 64-bit register");
+      }
+      // Always 64-bit, no REX.W needed.
+      EmitPlusReg({static_cast<std::uint8_t>(
+                      info->kind == Mnemonic::Kind::Push ? 0x50 : 0x58)},
+                  4, src);
+      return;
+    case Mnemonic::Kind::Call:
+    case Mnemonic::Kind::Jmp: {
+      const bool call = info->kind == Mnemonic::Kind::Call;
+      if (num_operands != 1) {
+        Error("expected one operand");
+      }
+      if (src.indirect) {
+        if (src.kind == Register && src.size != 8) {
+          Error("expected a 64-bit register");
+        }
+        EmitModRM({0xff}, 4, Digit(call ? 2 : 4), src);
+      } else if (src.kind == Symbol) {
+        EmitBranch({static_cast<std::uint8_t>(call ? 0xe8 : 0xe9)}, src,
+                   R_X86_64_PLT32);
+      } else {
+        Error("expected a symbol or an indirect target");
+      }
+      return;
+    }
+    case Mnemonic::Kind::Jcc:
+      expect({Symbol});
+      EmitBranch({0x0f, static_cast<std::uint8_t>(0x80 + info->code)}, src,
+                 R_X86_64_PLT32);
+      return;
+    case Mnemonic::Kind::Setcc:
+      if (num_operands != 1 || src.kind == Immediate || src.kind == Symbol ||
+          (src.kind == Register && src.size != 1)) {
+        Error("expected a byte register or memory");
+      }
+      EmitModRM({0x0f, static_cast<std::uint8_t>(0x90 + info->code)}, 1,
+                Digit(0), src);
+      return;
+    case Mnemonic::Kind::Movsxd:
+      if (num_operands != 2 || src.kind == Immediate || src.kind == Symbol ||
+          dst.kind != Register || dst.size != 8) {
+        Error("unexpected operands");
+      }
+      EmitModRM({0x63}, 8, dst, src);
+      return;
+    case Mnemonic::Kind::Extend: {
+      const int size = info->size != 0 ? info->size : dst.size;
+      if (num_operands != 2 || src.kind == Immediate || src.kind == Symbol ||
+          dst.kind != Register || dst.size != size ||
+          size <= info->src_size ||
+          (src.kind == Register && src.size != info->src_size)) {
+        Error("unexpected operands");
+      }
+      const std::uint8_t opcode =
+          (info->code ? 0xb6 : 0xbe) + (info->src_size == 2 ? 1 : 0);
+      EmitModRM({0x0f, opcode}, size, dst, src);
+      return;
+    }
+    default:
+      break;
+  }
+
+  // The rest take an operand size from a suffix or from their registers.
+  int size = info->size;
+  for (int i = 0; i < num_operands; i++) {
+    if (operands[i].kind != Register) {
+      continue;
+    }
+    if (size != 0 && size != operands[i].size) {
+      Error("operand size mismatch");
+    }
+    size = operands[i].size;
+  }
+  if (size == 0) {
+    Error("ambiguous operand size");
+  }
+  if (num_operands != 2) {
+    Error("expected two operands");
+  }
+  if (src.kind == Symbol || dst.kind == Symbol || dst.kind == Immediate ||
+      (src.kind == Memory && dst.kind == Memory)) {
+    Error("unexpected operands");
+  }
+  // Opcodes of byte operations are one less.
+  const std::uint8_t wide = size == 1 ? 0 : 1;
+  const int imm_size = std::min(size, 4);
+
+  if (info->kind == Mnemonic::Kind::Lea) {
+    if (src.kind != Memory || dst.kind != Register || size == 1) {
+      Error("unexpected operands");
+    }
+    EmitModRM({0x8d}, size, dst, src);
+  } else if (info->kind == Mnemonic::Kind::Mov) {
+    if (src.kind == Immediate) {
+      if (dst.kind == Register && (size != 8 || !IsInt32(src.value))) {
+        // movabs for 64 bits.
+        EmitPlusReg({static_cast<std::uint8_t>(size == 1 ? 0xb0 : 0xb8)},
+                    size, dst);
+        EmitImm(src.value, size);
+      } else {
+        EmitModRM({static_cast<std::uint8_t>(0xc6 + wide)}, size, Digit(0),
+                  dst, src.value, imm_size);
+      }
+    } else if (src.kind == Register) {
+      EmitModRM({static_cast<std::uint8_t>(0x88 + wide)}, size, src, dst);
+    } else {
+      EmitModRM({static_cast<std::uint8_t>(0x8a + wide)}, size, dst, src);
+    }
+  } else {
+    const int op = info->code;
+    const auto base = static_cast<std::uint8_t>(op * 8);
+    if (src.kind == Immediate) {
+      if (size != 1 && IsInt8(src.value)) {
+        EmitModRM({0x83}, size, Digit(op), dst, src.value, 1);
+      } else if (dst.kind == Register && dst.reg == 0) {
+        // A shorter form for the accumulator.
+        EmitPlusReg({static_cast<std::uint8_t>(base + 4 + wide)}, size, dst);
+        EmitImm(src.value, imm_size);
+      } else {
+        EmitModRM({static_cast<std::uint8_t>(0x80 + wide)}, size, Digit(op),
+                  dst, src.value, imm_size);
+      }
+    } else if (src.kind == Register) {
+      EmitModRM({static_cast<std::uint8_t>(base + wide)}, size, src, dst);
+    } else {
+      EmitModRM({static_cast<std::uint8_t>(base + 2 + wide)}, size, dst, src);
+    }
+  }
+}
+
+void Assembler::Error(std::string_view what) const {
+  jcc_unreachable(fmt::format("Can't assemble `{}`: {}!", line_, what));
+}
+
+std::size_t Assembler::GetSymbol(std::string_view name) {
+  if (name.empty()) {
+    Error("expected a symbol");
+  }
+  auto iter = symbol_table_.find(name);
+  if (iter != symbol_table_.end()) {
+    return iter->second;
+  }
+  symbols_.push_back({std::string(name)});
+  symbol_table_.emplace(symbols_.back().name, symbols_.size() - 1);
+  return symbols_.size() - 1;
+}
+
+void Assembler::DefineLabel(std::string_view name) {
+  Symbol& symbol = symbols_[GetSymbol(name)];
+  if (symbol.section != NumSections) {
+    Error("label already defined");
+  }
+  symbol.section = cur_;
+  symbol.value = Out().size();
+}
+
+void Assembler::EmitImm(std::int64_t value, int size) {
+  for (int i = 0; i < size; i++) {
+    Emit(static_cast<std::uint8_t>(value >> (i * 8)));
+  }
+}
+
+// spl, bpl, sil and dil are only encodable with a REX prefix, without one
+// their numbers stand for ah, ch, dh and bh.
+static bool NeedsRex(const Operand& operand) {
+  return operand.kind == Operand::Kind::Register && operand.size == 1 &&
+         operand.reg >= 4 && operand.reg < 8;
+}
+
+void Assembler::EmitModRM(Opcode opcode, int size, const Operand& reg,
+                          const Operand& rm, std::int64_t imm, int imm_size) {
+  if (size == 2) {
+    Emit(0x66);
+  }
+  std::uint8_t rex = size == 8 ? 0x48 : 0;
+  if (reg.reg & 8) {
+    rex |= 0x44;
+  }
+  if (rm.reg != rip && (rm.reg & 8)) {
+    rex |= 0x41;
+  }
+  if (NeedsRex(reg) || NeedsRex(rm)) {
+    rex |= 0x40;
+  }
+  if (rex != 0) {
+    Emit(rex);
+  }
+  for (std::uint8_t byte : opcode) {
+    Emit(byte);
+  }
+
+  const int reg_field = (reg.reg & 7) << 3;
+  if (rm.kind == Operand::Kind::Register) {
+    Emit(0xc0 | reg_field | (rm.reg & 7));
+  } else if (rm.reg == rip) {
+    Emit(reg_field | 5);
+    if (rm.symbol.empty()) {
+      EmitImm(rm.value, 4);
+    } else {
+      // The displacement is relative to the end of the instruction.
+      EmitFixup(rm.symbol, rm.value - 4 - imm_size,
+                rm.got ? R_X86_64_GOTPCREL : R_X86_64_PC32);
+    }
+  } else {
+    // rbp and r13 can't go without a displacement, that encoding means
+    // rip instead.
+    const int mod = rm.value == 0 && (rm.reg & 7) != 5 ? 0
+                    : IsInt8(rm.value)                 ? 1
+                                                       : 2;
+    if (mod == 2 && !IsInt32(rm.value)) {
+      Error("displacement out of range");
+    }
+    Emit((mod << 6) | reg_field | (rm.reg & 7));
+    // rsp and r12 need a SIB byte, without an index.
+    if ((rm.reg & 7) == 4) {
+      Emit(0x24);
+    }
+    EmitImm(rm.value, mod == 1 ? 1 : mod == 2 ? 4 : 0);
+  }
+  EmitImm(imm, imm_size);
+}
+
+void Assembler::EmitPlusReg(Opcode opcode, int size, const Operand& reg) {
+  if (size == 2) {
+    Emit(0x66);
+  }
+  std::uint8_t rex = size == 8 ? 0x48 : 0;
+  if (reg.reg & 8) {
+    rex |= 0x41;
+  }
+  if (NeedsRex(reg)) {
+    rex |= 0x40;
+  }
+  if (rex != 0) {
+    Emit(rex);
+  }
+  for (auto iter = opcode.begin(); iter != opcode.end(); ++iter) {
+    Emit(iter + 1 == opcode.end() ? *iter + (reg.reg & 7) : *iter);
+  }
+}
+
+void Assembler::EmitBranch(Opcode opcode, const Operand& target,
+                           std::uint32_t type) {
+  for (std::uint8_t byte : opcode) {
+    Emit(byte);
+  }
+  EmitFixup(target.symbol, -4, type);
+}
+
+void Assembler::EmitFixup(std::string_view symbol, std::int64_t addend,
+                          std::uint32_t type) {
+  fixups_.push_back({cur_, Out().size(), GetSymbol(symbol), addend, type});
+  EmitImm(0, 4);
+}
+}  // namespace jcc
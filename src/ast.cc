@@ -1,473 +1,287 @@
-#include <fmt/format.h>
-
 #include <string_view>
+#include <type_traits>
 
-#include "fmt/core.h"
 #include "jcc/ast_context.h"
-#include "jcc/codegen.h"
 #include "jcc/common.h"
 #include "jcc/decl.h"
 #include "jcc/expr.h"
+#include "jcc/identifier_table.h"
 #include "jcc/source_location.h"
 #include "jcc/stmt.h"
 #include "jcc/type.h"
 
 namespace jcc {
 
-static constexpr int dump_indent = 2;
-
-#define GEN(Node) \
-  void Node::GenCode(CodeGen& gen) { gen.Emit##Node(*this); }
-
-GEN(VarDecl)
-GEN(FunctionDecl)
-
-GEN(CompoundStatement)
-GEN(DeclStatement)
-GEN(WhileStatement)
-GEN(ForStatement)
-GEN(IfStatement)
-GEN(DoStatement)
-GEN(SwitchStatement)
-GEN(CaseStatement)
-GEN(ReturnStatement)
-GEN(BreakStatement)
-GEN(ContinueStatement)
-
-GEN(DeclRefExpr)
-GEN(BinaryExpr)
-GEN(UnaryExpr)
-GEN(RecordDecl)
-GEN(MemberExpr)
-GEN(ExprStatement)
-GEN(StringLiteral)
-GEN(CharacterLiteral)
-GEN(IntergerLiteral)
-GEN(CallExpr)
-GEN(FloatingLiteral)
-
-static void InsertIndent(int n) {
-  for (int i = 0; i < n; i++) {
-    fmt::print(" ");
-  }
-}
+// The allocator skips destructor bookkeeping for trivially destructible
+// nodes, and nodes keep everything they refer to in the context. Don't give
+// them members that need destruction.
+#define DECL(Name) static_assert(std::is_trivially_destructible_v<Name>);
+#define STMT(Name) DECL(Name)
+#include "jcc/ast_nodes.def"
 
 VarDecl* VarDecl::Create(ASTContext& ctx, SourceRange loc, Expr* init,
-                         Type* type, std::string name) {
+                         Type* type, IdentifierInfo* name) {
   void* mem = ctx.Allocate<VarDecl>();
-  auto* var = new (mem) VarDecl(std::move(loc), init, type, std::move(name));
-  ctx.GetCurScope().PushVar(var->GetName(), var);
-  return var;
-}
-
-void VarDecl::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("VarDecl: {}\n", GetName());
-
-  // If we have init.
-  if (init_ != nullptr) {
-    init_->dump(indent + dump_indent);
+  auto* var = new (mem) VarDecl(loc, init, type, name);
+  if (name != nullptr) {
+    ctx.PushVar(name, var);
   }
+  return var;
 }
 
 FunctionDecl* FunctionDecl::Create(ASTContext& ctx, SourceRange loc,
-                                   std::string name, std::vector<VarDecl*> args,
-                                   Type* type, Type* return_type, Stmt* body) {
+                                   IdentifierInfo* name,
+                                   std::span<VarDecl* const> args, Type* type,
+                                   Type* return_type, Stmt* body) {
   void* mem = ctx.Allocate<FunctionDecl>();
-  auto* function =
-      new (mem) FunctionDecl(std::move(loc), std::move(name), std::move(args),
-                             type, return_type, body);
-  ctx.GetCurScope().PushVar(name, function);
+  auto* function = new (mem) FunctionDecl(
+      loc, name, ctx.CopyArray<VarDecl*>(args), type, return_type, body);
+  ctx.PushVar(name, function);
   return function;
 }
 
 FunctionDecl* FunctionDecl::Create(ASTContext& ctx, SourceRange loc,
-                                   const std::string& name, Type* type,
+                                   IdentifierInfo* name, Type* type,
                                    Type* return_type) {
   void* mem = ctx.Allocate<FunctionDecl>();
-  auto* function =
-      new (mem) FunctionDecl(std::move(loc), name, type, return_type);
-  ctx.GetCurScope().PushVar(name, function);
+  auto* function = new (mem) FunctionDecl(loc, name, type, return_type);
+  ctx.PushVar(name, function);
   return function;
 }
 
-void FunctionDecl::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("FunctionDecl: {}\n", GetName());
-  InsertIndent(indent + dump_indent);
-  fmt::print("Args[{}]\n", GetParamNum());
-  for (const auto* arg : args_) {
-    arg->dump(indent + dump_indent);
+RecordDecl* RecordDecl::Create(ASTContext& ctx, SourceRange loc,
+                               IdentifierInfo* name,
+                               std::span<VarDecl* const> members) {
+  void* mem = ctx.Allocate<RecordDecl>();
+  return new (mem) RecordDecl{loc, name, ctx.CopyArray<VarDecl*>(members)};
+}
+
+static int HexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
   }
-  if (body_ != nullptr) {
-    body_->dump(indent + dump_indent);
-  } else {
-    InsertIndent(indent + dump_indent);
-    fmt::print("Body(empty)\n");
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
   }
+  return -1;
 }
 
-RecordDecl* RecordDecl::Create(ASTContext& ctx, SourceRange loc,
-                               std::string name,
-                               std::vector<VarDecl*> members) {
-  void* mem = ctx.Allocate<RecordDecl>();
-  return new (mem)
-      RecordDecl{std::move(loc), std::move(name), std::move(members)};
+// Decodes the escape sequence starting with the backslash at `spelling[idx]`
+// and moves `idx` past it.
+static char DecodeEscape(std::string_view spelling, std::size_t& idx) {
+  assert(spelling[idx] == '\\' && "Not an escape sequence!");
+  if (++idx == spelling.size()) {
+    jcc_unreachable("Incomplete escape sequence!");
+  }
+  char c = spelling[idx++];
+  switch (c) {
+    case 'a':
+      return '\a';
+    case 'b':
+      return '\b';
+    case 'e':  // GNU extension.
+      return 27;
+    case 'f':
+      return '\f';
+    case 'n':
+      return '\n';
+    case 'r':
+      return '\r';
+    case 't':
+      return '\t';
+    case 'v':
+      return '\v';
+    case 'x': {
+      int value = 0;
+      while (idx < spelling.size() && HexValue(spelling[idx]) != -1) {
+        value = value * 16 + HexValue(spelling[idx++]);
+      }
+      return static_cast<char>(value);
+    }
+    default:
+      break;
+  }
+  if (c >= '0' && c <= '7') {
+    // Up to three octal digits.
+    int value = c - '0';
+    for (int digits = 1; digits < 3 && idx < spelling.size() &&
+                         spelling[idx] >= '0' && spelling[idx] <= '7';
+         digits++) {
+      value = value * 8 + (spelling[idx++] - '0');
+    }
+    return static_cast<char>(value);
+  }
+  // \\, \', \", \? and unknown escapes stand for the character itself.
+  return c;
 }
 
-void RecordDecl::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("RecordDecl: {}\n", GetName());
-  for (const auto* member : members_) {
-    member->dump(indent + dump_indent);
+// Most literals have no escape sequence and are used as they are spelled.
+// The others are decoded into the context.
+static std::string_view DecodeLiteral(ASTContext& ctx,
+                                      std::string_view spelling) {
+  std::size_t escape = spelling.find('\\');
+  if (escape == std::string_view::npos) {
+    return spelling;
+  }
+
+  // Decoding never makes a literal longer.
+  std::span<char> decoded = ctx.AllocateArray<char>(spelling.size());
+  std::copy_n(spelling.begin(), escape, decoded.begin());
+  std::size_t size = escape;
+  for (std::size_t idx = escape; idx < spelling.size();) {
+    decoded[size++] = spelling[idx] == '\\' ? DecodeEscape(spelling, idx)
+                                           : spelling[idx++];
   }
+  return {decoded.data(), size};
 }
+
 StringLiteral* StringLiteral::Create(ASTContext& ctx, SourceRange loc,
-                                     std::string literal) {
+                                     std::string_view spelling) {
   void* mem = ctx.Allocate<StringLiteral>();
-  Type* type = Type::CreatePointerType(
-      ctx, Type::CreateCharType(ctx, /*is_unsigned=*/false));
-  return new (mem) StringLiteral(std::move(loc), type, std::move(literal));
-}
-
-void StringLiteral::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("StringLiteral: {}\n", GetValue());
+  Type* type = ctx.GetPointerType(ctx.GetCharType());
+  return new (mem) StringLiteral(loc, type, DecodeLiteral(ctx, spelling));
 }
 
 CharacterLiteral* CharacterLiteral::Create(ASTContext& ctx, SourceRange loc,
-                                           Type* type, std::string value) {
+                                           Type* type,
+                                           std::string_view spelling) {
+  std::string_view value = DecodeLiteral(ctx, spelling);
+  if (value.size() != 1) {
+    jcc_unimplemented();  // Multi-character constants.
+  }
   void* mem = ctx.Allocate<CharacterLiteral>();
-  auto* expr =
-      new (mem) CharacterLiteral(std::move(loc), type, std::move(value));
+  auto* expr = new (mem) CharacterLiteral(loc, type, value[0]);
   expr->SetType(ctx.GetCharType());
   return expr;
 }
 
-void CharacterLiteral::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("CharacterLiteral: {}\n", GetValue());
-}
-
 IntergerLiteral* IntergerLiteral::Create(ASTContext& ctx, SourceRange loc,
                                          Type* type, int value) {
   void* mem = ctx.Allocate<IntergerLiteral>();
-  auto* expr = new (mem) IntergerLiteral{std::move(loc), type, value};
+  auto* expr = new (mem) IntergerLiteral{loc, type, value};
   expr->SetType(ctx.GetIntType());
   return expr;
 }
 
-void IntergerLiteral::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("IntergerLiteral: {}\n", GetValue());
-}
-
 FloatingLiteral* FloatingLiteral::Create(ASTContext& ctx, SourceRange loc,
                                          Type* type, double value) {
   void* mem = ctx.Allocate<FloatingLiteral>();
-  auto* expr = new (mem) FloatingLiteral(std::move(loc), type, value);
+  auto* expr = new (mem) FloatingLiteral(loc, type, value);
   expr->SetType(ctx.GetFloatType());
   return expr;
 }
 
-void FloatingLiteral::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("FloatingLiteral: {}\n", GetValue());
-}
-
 CallExpr* CallExpr::Create(ASTContext& ctx, SourceRange loc, Type* type,
-                           Expr* callee, std::vector<Expr*> args) {
+                           Expr* callee, std::span<Expr* const> args) {
   void* mem = ctx.Allocate<CallExpr>();
-  return new (mem) CallExpr(std::move(loc), type, callee, std::move(args));
-}
-
-void CallExpr::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("CallExpr: {}\n", GetCallee()
-                                   ->As<DeclRefExpr>()
-                                   ->GetRefDecl()
-                                   ->As<FunctionDecl>()
-                                   ->GetName());
+  return new (mem) CallExpr(loc, type, callee, ctx.CopyArray<Expr*>(args));
 }
 
 UnaryExpr* UnaryExpr::Create(ASTContext& ctx, SourceRange loc, Type* type,
                              UnaryOperatorKind kind, Stmt* value) {
   void* mem = ctx.Allocate<UnaryExpr>();
-  return new (mem) UnaryExpr(std::move(loc), type, kind, value);
-}
-
-static std::string_view PrintUnaryOpKind(UnaryOperatorKind kind) {
-  switch (kind) {
-    case UnaryOperatorKind::AddressOf:
-      return "&";
-    case UnaryOperatorKind::PostIncrement:
-      return "++";
-    case UnaryOperatorKind::PostDecrement:
-      return "--";
-    default:
-      jcc_unimplemented();
-  }
-}
-void UnaryExpr::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("UnaryExpr({}):\n", PrintUnaryOpKind(kind_));
-  value_->dump(indent + dump_indent);
+  return new (mem) UnaryExpr(loc, type, kind, value);
 }
 
 BinaryExpr* BinaryExpr::Create(ASTContext& ctx, SourceRange loc, Type* type,
                                BinaryOperatorKind kind, Expr* lhs, Expr* rhs) {
   void* mem = ctx.Allocate<BinaryExpr>();
-  return new (mem) BinaryExpr(std::move(loc), type, kind, lhs, rhs);
+  return new (mem) BinaryExpr(loc, type, kind, lhs, rhs);
 }
 
-static std::string_view PrintBinaryOpKind(BinaryOperatorKind kind) {
-  switch (kind) {
-    case BinaryOperatorKind::Plus:
-      return "+";
-    case BinaryOperatorKind::PlusEqual:
-      return "+=";
-    case BinaryOperatorKind::Minus:
-      return "-";
-    case BinaryOperatorKind::MinusEqual:
-      return "-=";
-    case BinaryOperatorKind::Multiply:
-      return "*";
-    case BinaryOperatorKind::MultiplyEqual:
-      return "*=";
-    case BinaryOperatorKind::Divide:
-      return "/";
-    case BinaryOperatorKind::DivideEqual:
-      return "/=";
-    case BinaryOperatorKind::Greater:
-      return ">";
-    case BinaryOperatorKind::GreaterEqual:
-      return ">=";
-    case BinaryOperatorKind::Less:
-      return "<";
-    case BinaryOperatorKind::LessEqual:
-      return "<=";
-    case BinaryOperatorKind::Equal:
-      return "=";
-    case BinaryOperatorKind::EqualEqual:
-      return "==";
-    default:
-      jcc_unimplemented();
-  }
-}
-void BinaryExpr::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("BinaryExpr({}):\n", PrintBinaryOpKind(kind_));
-  lhs_->dump(indent + dump_indent);
-  rhs_->dump(indent + dump_indent);
-}
-
-void MemberExpr::dump(int indent) const { jcc_unimplemented(); }
-
 DeclRefExpr* DeclRefExpr::Create(ASTContext& ctx, SourceRange loc, Type* type,
                                  Decl* decl) {
   void* mem = ctx.Allocate<DeclRefExpr>();
-  auto* expr = new (mem) DeclRefExpr(std::move(loc), type, decl);
+  auto* expr = new (mem) DeclRefExpr(loc, type, decl);
   expr->SetType(ctx.GetIntType());
   return expr;
 }
 
-void DeclRefExpr::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("DeclRefExpr: {}\n", decl_->GetName());
-}
-
 ReturnStatement* ReturnStatement::Create(ASTContext& ctx, SourceRange loc,
                                          Expr* return_expr) {
   void* mem = ctx.Allocate<ReturnStatement>();
-  return new (mem) ReturnStatement(std::move(loc), return_expr);
-}
-
-void ReturnStatement::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("ReturnStatement\n");
-  if (return_expr_ != nullptr) {
-    return_expr_->dump(indent + dump_indent);
-  } else {
-    InsertIndent(indent + dump_indent);
-    fmt::print("Empty\n");
-  }
+  return new (mem) ReturnStatement(loc, return_expr);
 }
 
 IfStatement* IfStatement::Create(ASTContext& ctx, SourceRange loc,
                                  Expr* condition, Stmt* then_stmt,
                                  Stmt* else_stmt) {
   void* mem = ctx.Allocate<IfStatement>();
-  return new (mem) IfStatement(std::move(loc), condition, then_stmt, else_stmt);
-}
-
-void IfStatement::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("IfStatement\n");
-  condition_->dump(indent + dump_indent);
-  // FIXME: they're not always exsits.
-  then_stmt_->dump(indent + dump_indent);
-  else_stmt_->dump(indent + dump_indent);
+  return new (mem) IfStatement(loc, condition, then_stmt, else_stmt);
 }
 
 WhileStatement* WhileStatement::Create(ASTContext& ctx, SourceRange loc,
                                        Expr* condition, Stmt* body) {
   void* mem = ctx.Allocate<WhileStatement>();
-  return new (mem) WhileStatement(std::move(loc), condition, body);
-}
-
-void WhileStatement::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("WhileStatement\n");
-  condition_->dump(indent + dump_indent);
-  // FIXME: it's not always exsits.
-  body_->dump(indent + dump_indent);
+  return new (mem) WhileStatement(loc, condition, body);
 }
 
 DoStatement* DoStatement::Create(ASTContext& ctx, SourceRange loc,
                                  Expr* condition, Stmt* body) {
   void* mem = ctx.Allocate<DoStatement>();
-  return new (mem) DoStatement(std::move(loc), condition, body);
-}
-
-void DoStatement::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("DoStatement\n");
-  // FIXME: it's not always exsits.
-  body_->dump(indent + dump_indent);
-  condition_->dump(indent + dump_indent);
+  return new (mem) DoStatement(loc, condition, body);
 }
 
 ForStatement* ForStatement::Create(ASTContext& ctx, SourceRange loc, Stmt* init,
                                    Stmt* condition, Stmt* increment,
                                    Stmt* body) {
   void* mem = ctx.Allocate<ForStatement>();
-  return new (mem)
-      ForStatement(std::move(loc), init, condition, increment, body);
-}
-
-void ForStatement::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("ForStatement:\n");
-
-  if (init_ != nullptr) {
-    init_->dump(indent + dump_indent);
-  }
-  if (condition_ != nullptr) {
-    condition_->dump(indent + dump_indent);
-  }
-  if (increment_ != nullptr) {
-    increment_->dump(indent + dump_indent);
-  }
-  if (body_ != nullptr) {
-    body_->dump(indent + dump_indent);
-  }
+  return new (mem) ForStatement(loc, init, condition, increment, body);
 }
 
 SwitchStatement* SwitchStatement::Create(ASTContext& ctx, SourceRange loc,
                                          Expr* condition,
                                          CompoundStatement* body) {
   void* mem = ctx.Allocate<SwitchStatement>();
-  return new (mem) SwitchStatement(std::move(loc), condition, body);
-}
-
-void SwitchStatement::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("SwitchStatement\n");
-  condition_->dump(indent + dump_indent);
-  body_->dump(indent + dump_indent);
+  return new (mem) SwitchStatement(loc, condition, body);
 }
 
 CaseStatement* CaseStatement::Create(ASTContext& ctx, SourceRange loc,
-                                     Stmt* stmt,
-                                     std::optional<std::string> value,
+                                     Stmt* stmt, std::string_view value,
                                      bool is_default) {
   void* mem = ctx.Allocate<CaseStatement>();
-  return new (mem)
-      CaseStatement(std::move(loc), stmt, std::move(value), is_default);
-}
-
-void CaseStatement::dump(int indent) const {
-  InsertIndent(indent);
-  if (IsDefault()) {
-    fmt::print("DefaultStatement\n");
-  } else {
-    fmt::print("CaseStatement\n");
-    InsertIndent(indent);
-    fmt::print("value: {}\n", GetValue());
-  }
-  stmt_->dump(indent + dump_indent);
+  return new (mem) CaseStatement(loc, stmt, value, is_default);
 }
 
 DeclStatement* DeclStatement::Create(ASTContext& ctx, SourceRange loc,
-                                     std::vector<Decl*> decls) {
+                                     std::span<Decl* const> decls) {
   void* mem = ctx.Allocate<DeclStatement>();
-  return new (mem) DeclStatement(std::move(loc), std::move(decls));
+  return new (mem) DeclStatement(loc, ctx.CopyArray<Decl*>(decls));
 }
 DeclStatement* DeclStatement::Create(ASTContext& ctx, SourceRange loc,
                                      Decl* decl) {
-  void* mem = ctx.Allocate<DeclStatement>();
-  return new (mem) DeclStatement(std::move(loc), decl);
-}
-
-void DeclStatement::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("DeclStatement\n");
-  for (const auto* decl : decls_) {
-    decl->dump(indent + dump_indent);
-  }
+  return Create(ctx, loc, {&decl, 1});
 }
 
-CompoundStatement* CompoundStatement::Create(ASTContext& ctx, SourceRange loc) {
+CompoundStatement* CompoundStatement::Create(ASTContext& ctx, SourceRange loc,
+                                             std::span<Stmt* const> stmts) {
   void* mem = ctx.Allocate<CompoundStatement>();
-  return new (mem) CompoundStatement(std::move(loc));
-}
-
-void CompoundStatement::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("CompoundStatement\n");
-  for (const auto* stmt : stmts_) {
-    stmt->dump(indent + dump_indent);
-  }
+  return new (mem) CompoundStatement(loc, ctx.CopyArray<Stmt*>(stmts));
 }
 
 ExprStatement* ExprStatement::Create(ASTContext& ctx, SourceRange loc,
                                      Expr* expr) {
   void* mem = ctx.Allocate<ExprStatement>();
-  return new (mem) ExprStatement(std::move(loc), expr);
-}
-
-void ExprStatement::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("ExprStatement\n");
-  expr_->dump(indent + dump_indent);
+  return new (mem) ExprStatement(loc, expr);
 }
 
 BreakStatement* BreakStatement::Create(ASTContext& ctx, SourceRange loc,
                                        SourceRange break_loc) {
   void* mem = ctx.Allocate<BreakStatement>();
-  return new (mem) BreakStatement(std::move(loc), std::move(break_loc));
-}
-
-void BreakStatement::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("BreakStatement\n");
+  return new (mem) BreakStatement(loc, break_loc);
 }
 
 ContinueStatement* ContinueStatement::Create(ASTContext& ctx, SourceRange loc,
                                              SourceRange continue_loc) {
   void* mem = ctx.Allocate<ContinueStatement>();
-  return new (mem) ContinueStatement(std::move(loc), std::move(continue_loc));
+  return new (mem) ContinueStatement(loc, continue_loc);
 }
 
-void ContinueStatement::dump(int indent) const {
-  InsertIndent(indent);
-  fmt::print("ContinueStatement\n");
+std::string_view Decl::GetName() const {
+  return name_ != nullptr ? name_->GetName() : std::string_view();
 }
 
-Stmt::~Stmt() = default;
-
-Expr::~Expr() = default;
-
-Decl::~Decl() = default;
-
 }  // namespace jcc
@@ -1,41 +1,106 @@
 #include "jcc/ast_context.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "jcc/type.h"
 
 namespace jcc {
 
-Type* ASTContext::GetVoidType() { return Type::CreateVoidType(*this); }
-Type* ASTContext::GetBoolType() { return Type::CreateBoolType(*this); }
-Type* ASTContext::GetCharType() {
-  return Type::CreateCharType(*this, /*is_unsigned=*/false);
-}
-Type* ASTContext::GetShortType() {
-  return Type::CreateShortType(*this, /*is_unsigned=*/false);
-}
-Type* ASTContext::GetIntType() {
-  return Type::CreateIntType(*this, /*is_unsigned=*/false);
-}
-Type* ASTContext::GetLongType() {
-  return Type::CreateLongType(*this, /*is_unsigned=*/false);
-}
-Type* ASTContext::GetUCharType() {
-  return Type::CreateCharType(*this, /*is_unsigned=*/true);
-}
-Type* ASTContext::GetUShortType() {
-  return Type::CreateShortType(*this, /*is_unsigned=*/true);
+// Builtin types don't depend on the context and are never modified once
+// created, so all contexts share these.
+static constinit Type void_type(TypeKind::Void, 2, 1);
+static constinit Type bool_type(TypeKind::Bool, 1, 1);
+static constinit Type char_type(TypeKind::Char, 1, 1);
+static constinit Type short_type(TypeKind::Short, 2, 2);
+static constinit Type int_type(TypeKind::Int, 4, 4);
+static constinit Type long_type(TypeKind::Long, 8, 8);
+static constinit Type uchar_type(TypeKind::Char, 1, 1, /*is_unsigned=*/true);
+static constinit Type ushort_type(TypeKind::Short, 2, 2, /*is_unsigned=*/true);
+static constinit Type uint_type(TypeKind::Int, 4, 4, /*is_unsigned=*/true);
+static constinit Type ulong_type(TypeKind::Long, 8, 8, /*is_unsigned=*/true);
+static constinit Type float_type(TypeKind::Float, 4, 4);
+static constinit Type double_type(TypeKind::Double, 8, 8);
+static constinit Type ldouble_type(TypeKind::Double, 16, 16);
+
+ASTContext::ASTContext(IdentifierTable& idents) : idents_(idents) {}
+
+Type* ASTContext::GetVoidType() { return &void_type; }
+Type* ASTContext::GetBoolType() { return &bool_type; }
+Type* ASTContext::GetCharType() { return &char_type; }
+Type* ASTContext::GetShortType() { return &short_type; }
+Type* ASTContext::GetIntType() { return &int_type; }
+Type* ASTContext::GetLongType() { return &long_type; }
+Type* ASTContext::GetUCharType() { return &uchar_type; }
+Type* ASTContext::GetUShortType() { return &ushort_type; }
+Type* ASTContext::GetUIntType() { return &uint_type; }
+Type* ASTContext::GetULongType() { return &ulong_type; }
+Type* ASTContext::GetFloatType() { return &float_type; }
+Type* ASTContext::GetDoubleType() { return &double_type; }
+Type* ASTContext::GetLDoubleType() { return &ldouble_type; }
+
+bool ASTContext::TypeKey::operator==(const TypeKey& other) const {
+  return derivation == other.derivation && base == other.base &&
+         extra == other.extra && std::ranges::equal(params, other.params);
 }
-Type* ASTContext::GetUIntType() {
-  return Type::CreateIntType(*this, /*is_unsigned=*/true);
+
+std::size_t ASTContext::TypeKey::Hash::operator()(const TypeKey& key) const {
+  std::size_t hash = std::hash<const Type*>()(key.base);
+  auto combine = [&hash](std::size_t value) {
+    hash ^= value + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+  };
+  combine(static_cast<std::size_t>(key.derivation));
+  combine(key.extra);
+  for (const Type* param : key.params) {
+    combine(std::hash<const Type*>()(param));
+  }
+  return hash;
 }
-Type* ASTContext::GetULongType() {
-  return Type::CreateLongType(*this, /*is_unsigned=*/true);
+
+Type* ASTContext::GetPointerType(Type* base) {
+  Type*& type = derived_types_[{TypeKey::Derivation::Pointer, base,
+                                 /*extra=*/0, /*params=*/{}}];
+  if (type == nullptr) {
+    type = Type::CreatePointerType(*this, base);
+  }
+  return type;
 }
-Type* ASTContext::GetFloatType() { return Type::CreateFloatType(*this); }
-Type* ASTContext::GetDoubleType() {
-  return Type::CreateDoubleType(*this, /*is_long=*/false);
+
+Type* ASTContext::GetArrayType(Type* base, std::size_t len) {
+  Type*& type =
+      derived_types_[{TypeKey::Derivation::Array, base, len, /*params=*/{}}];
+  if (type == nullptr) {
+    type = Type::CreateArrayType(*this, base, len);
+  }
+  return type;
 }
-Type* ASTContext::GetLDoubleType() {
-  return Type::CreateDoubleType(*this, /*is_long=*/true);
+
+Type* ASTContext::GetFunctionType(Type* return_type,
+                                  std::span<Type* const> params) {
+  TypeKey key{TypeKey::Derivation::Function, return_type, /*extra=*/0, params};
+  if (auto iter = derived_types_.find(key); iter != derived_types_.end()) {
+    return iter->second;
+  }
+  auto* type = Type::CreateFuncType(*this, return_type, params)
+                   ->AsType<FunctionType>();
+  // `params` belongs to the caller.
+  key.params = type->GetParams();
+  derived_types_.emplace(key, type);
+  return type;
 }
 
+Type* ASTContext::GetQualifiedType(Type* base, Qualifiers quals,
+                                   bool is_static) {
+  if (quals == Qualifiers::Unspecified && !is_static) {
+    return base;
+  }
+  std::uint64_t extra =
+      static_cast<std::uint64_t>(quals) << 1 | static_cast<int>(is_static);
+  Type*& type = derived_types_[{TypeKey::Derivation::Qualified, base, extra,
+                                 /*params=*/{}}];
+  if (type == nullptr) {
+    type = Type::CreateQualifiedType(*this, base, quals, is_static);
+  }
+  return type;
+}
 }  // namespace jcc
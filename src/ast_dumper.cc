@@ -0,0 +1,274 @@
+#include "jcc/ast_dumper.h"
+
+#include <fmt/format.h>
+
+#include <initializer_list>
+#include <string_view>
+
+#include "jcc/casting.h"
+#include "jcc/common.h"
+#include "jcc/decl.h"
+#include "jcc/expr.h"
+#include "jcc/stmt.h"
+
+namespace jcc {
+
+static constexpr int dump_indent = 2;
+
+static std::string_view GetKindName(ASTNodeKind kind) {
+  switch (kind) {
+#define DECL(Name)        \
+  case ASTNodeKind::Name: \
+    return #Name;
+#define STMT(Name) DECL(Name)
+#include "jcc/ast_nodes.def"
+  }
+  return "ASTNode";
+}
+
+void ASTDumper::InsertIndent() const {
+  for (int i = 0; i < indent_; i++) {
+    fmt::print(" ");
+  }
+}
+
+void ASTDumper::DumpChild(ASTNode* node) {
+  indent_ += dump_indent;
+  Visit(node);
+  indent_ -= dump_indent;
+}
+
+void ASTDumper::VisitVarDecl(VarDecl& decl) {
+  InsertIndent();
+  fmt::print("VarDecl: {}\n", decl.GetName());
+
+  // If we have init.
+  if (decl.GetInit() != nullptr) {
+    DumpChild(decl.GetInit());
+  }
+}
+
+void ASTDumper::VisitFunctionDecl(FunctionDecl& decl) {
+  InsertIndent();
+  fmt::print("FunctionDecl: {}\n", decl.GetName());
+  indent_ += dump_indent;
+  InsertIndent();
+  fmt::print("Args[{}]\n", decl.GetParamNum());
+  for (std::size_t idx = 0; idx < decl.GetParamNum(); idx++) {
+    Visit(decl.GetParam(idx));
+  }
+  if (decl.GetBody() != nullptr) {
+    Visit(decl.GetBody());
+  } else {
+    InsertIndent();
+    fmt::print("Body(empty)\n");
+  }
+  indent_ -= dump_indent;
+}
+
+void ASTDumper::VisitRecordDecl(RecordDecl& decl) {
+  InsertIndent();
+  fmt::print("RecordDecl: {}\n", decl.GetName());
+  for (std::size_t idx = 0; idx < decl.GetMemberNum(); idx++) {
+    DumpChild(decl.GetMember(idx));
+  }
+}
+
+void ASTDumper::VisitStringLiteral(StringLiteral& expr) {
+  InsertIndent();
+  fmt::print("StringLiteral: {}\n", expr.GetValue());
+}
+
+void ASTDumper::VisitCharacterLiteral(CharacterLiteral& expr) {
+  InsertIndent();
+  fmt::print("CharacterLiteral: {}\n", expr.GetValue());
+}
+
+void ASTDumper::VisitIntergerLiteral(IntergerLiteral& expr) {
+  InsertIndent();
+  fmt::print("IntergerLiteral: {}\n", expr.GetValue());
+}
+
+void ASTDumper::VisitFloatingLiteral(FloatingLiteral& expr) {
+  InsertIndent();
+  fmt::print("FloatingLiteral: {}\n", expr.GetValue());
+}
+
+void ASTDumper::VisitCallExpr(CallExpr& expr) {
+  InsertIndent();
+  fmt::print(
+      "CallExpr: {}\n",
+      cast<FunctionDecl>(cast<DeclRefExpr>(expr.GetCallee())->GetRefDecl())
+          ->GetName());
+}
+
+static std::string_view PrintUnaryOpKind(UnaryOperatorKind kind) {
+  switch (kind) {
+    case UnaryOperatorKind::AddressOf:
+      return "&";
+    case UnaryOperatorKind::PostIncrement:
+      return "++";
+    case UnaryOperatorKind::PostDecrement:
+      return "--";
+    default:
+      jcc_unimplemented();
+  }
+}
+void ASTDumper::VisitUnaryExpr(UnaryExpr& expr) {
+  InsertIndent();
+  fmt::print("UnaryExpr({}):\n", PrintUnaryOpKind(expr.getKind()));
+  DumpChild(expr.GetValue());
+}
+
+static std::string_view PrintBinaryOpKind(BinaryOperatorKind kind) {
+  switch (kind) {
+    case BinaryOperatorKind::Plus:
+      return "+";
+    case BinaryOperatorKind::PlusEqual:
+      return "+=";
+    case BinaryOperatorKind::Minus:
+      return "-";
+    case BinaryOperatorKind::MinusEqual:
+      return "-=";
+    case BinaryOperatorKind::Multiply:
+      return "*";
+    case BinaryOperatorKind::MultiplyEqual:
+      return "*=";
+    case BinaryOperatorKind::Divide:
+      return "/";
+    case BinaryOperatorKind::DivideEqual:
+      return "/=";
+    case BinaryOperatorKind::Greater:
+      return ">";
+    case BinaryOperatorKind::GreaterEqual:
+      return ">=";
+    case BinaryOperatorKind::Less:
+      return "<";
+    case BinaryOperatorKind::LessEqual:
+      return "<=";
+    case BinaryOperatorKind::Equal:
+      return "=";
+    case BinaryOperatorKind::EqualEqual:
+      return "==";
+    default:
+      jcc_unimplemented();
+  }
+}
+void ASTDumper::VisitBinaryExpr(BinaryExpr& expr) {
+  InsertIndent();
+  fmt::print("BinaryExpr({}):\n", PrintBinaryOpKind(expr.GetKind()));
+  DumpChild(expr.GetLhs());
+  DumpChild(expr.GetRhs());
+}
+
+void ASTDumper::VisitDeclRefExpr(DeclRefExpr& expr) {
+  InsertIndent();
+  fmt::print("DeclRefExpr: {}\n", expr.GetRefDecl()->GetName());
+}
+
+void ASTDumper::VisitReturnStatement(ReturnStatement& stmt) {
+  InsertIndent();
+  fmt::print("ReturnStatement\n");
+  if (stmt.GetReturn() != nullptr) {
+    DumpChild(stmt.GetReturn());
+  } else {
+    indent_ += dump_indent;
+    InsertIndent();
+    fmt::print("Empty\n");
+    indent_ -= dump_indent;
+  }
+}
+
+void ASTDumper::VisitIfStatement(IfStatement& stmt) {
+  InsertIndent();
+  fmt::print("IfStatement\n");
+  DumpChild(stmt.GetCondition());
+  // FIXME: they're not always exsits.
+  DumpChild(stmt.GetThen());
+  DumpChild(stmt.GetElse());
+}
+
+void ASTDumper::VisitWhileStatement(WhileStatement& stmt) {
+  InsertIndent();
+  fmt::print("WhileStatement\n");
+  DumpChild(stmt.GetCondition());
+  // FIXME: it's not always exsits.
+  DumpChild(stmt.GetBody());
+}
+
+void ASTDumper::VisitDoStatement(DoStatement& stmt) {
+  InsertIndent();
+  fmt::print("DoStatement\n");
+  // FIXME: it's not always exsits.
+  DumpChild(stmt.GetBody());
+  DumpChild(stmt.GetCondition());
+}
+
+void ASTDumper::VisitForStatement(ForStatement& stmt) {
+  InsertIndent();
+  fmt::print("ForStatement:\n");
+
+  for (Stmt* child : {stmt.GetInit(), stmt.GetCondition(),
+                      stmt.GetIncrement(), stmt.GetBody()}) {
+    if (child != nullptr) {
+      DumpChild(child);
+    }
+  }
+}
+
+void ASTDumper::VisitSwitchStatement(SwitchStatement& stmt) {
+  InsertIndent();
+  fmt::print("SwitchStatement\n");
+  DumpChild(stmt.GetCondition());
+  DumpChild(stmt.GetBody());
+}
+
+void ASTDumper::VisitCaseStatement(CaseStatement& stmt) {
+  InsertIndent();
+  if (stmt.IsDefault()) {
+    fmt::print("DefaultStatement\n");
+  } else {
+    fmt::print("CaseStatement\n");
+    InsertIndent();
+    fmt::print("value: {}\n", stmt.GetValue());
+  }
+  DumpChild(stmt.GetStmt());
+}
+
+void ASTDumper::VisitDeclStatement(DeclStatement& stmt) {
+  InsertIndent();
+  fmt::print("DeclStatement\n");
+  for (Decl* decl : stmt.GetDecls()) {
+    DumpChild(decl);
+  }
+}
+
+void ASTDumper::VisitCompoundStatement(CompoundStatement& stmt) {
+  InsertIndent();
+  fmt::print("CompoundStatement\n");
+  for (std::size_t idx = 0; idx < stmt.GetSize(); idx++) {
+    DumpChild(stmt.GetStmt(idx));
+  }
+}
+
+void ASTDumper::VisitExprStatement(ExprStatement& stmt) {
+  InsertIndent();
+  fmt::print("ExprStatement\n");
+  DumpChild(stmt.GetExpr());
+}
+
+void ASTDumper::VisitBreakStatement(BreakStatement&) {
+  InsertIndent();
+  fmt::print("BreakStatement\n");
+}
+
+void ASTDumper::VisitContinueStatement(ContinueStatement&) {
+  InsertIndent();
+  fmt::print("ContinueStatement\n");
+}
+
+void ASTDumper::VisitASTNode(ASTNode& node) {
+  InsertIndent();
+  fmt::print("{}\n", GetKindName(node.GetKind()));
+}
+}  // namespace jcc
@@ -1,5 +0,0 @@
-#include "jcc/ast_node.h"
-
-namespace jcc {
-ASTNode::~ASTNode() = default;
-}
@@ -0,0 +1,222 @@
+#include "jcc/char_scanner.h"
+
+#include <cstdint>
+#include <initializer_list>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// The vectorized scanners load whole aligned blocks, which may include bytes
+// before the start of the buffer or after its NUL terminator. That's fine in
+// practice, an aligned block never crosses a page, but the address sanitizer
+// would rightfully complain.
+#define NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+
+namespace jcc {
+
+static bool IsWhitespace(char cha) {
+  return cha == ' ' || (cha >= '\t' && cha <= '\r');
+}
+
+static bool IsIdentifierChar(char cha) {
+  return (cha >= 'a' && cha <= 'z') || (cha >= 'A' && cha <= 'Z') ||
+         cha == '_';
+}
+
+static bool IsDigitChar(char cha) {
+  return (cha >= '0' && cha <= '9') || cha == '.';
+}
+
+template <bool (*IsMember)(char)>
+static const char* ScanScalar(const char* ptr) {
+  while (IsMember(*ptr)) {
+    ptr++;
+  }
+  return ptr;
+}
+
+static const char* FindCommentEndScalar(const char* ptr) {
+  while (*ptr != '\0' && !(ptr[0] == '*' && ptr[1] == '/')) {
+    ptr++;
+  }
+  return ptr;
+}
+
+static constexpr CharScanner scalar_scanner{
+    CharScanner::Kind::Scalar, ScanScalar<IsWhitespace>,
+    ScanScalar<IsIdentifierChar>, ScanScalar<IsDigitChar>,
+    FindCommentEndScalar};
+
+#if defined(__SSE2__)
+
+// Each classifier returns a bit mask of the bytes belonging to its class.
+// SSE2 has no unsigned byte comparison, so range checks are done as
+// `min(x - lo, hi - lo) == x - lo`.
+static int WhitespaceSSE2(__m128i chars) {
+  __m128i space = _mm_cmpeq_epi8(chars, _mm_set1_epi8(' '));
+  __m128i offset = _mm_sub_epi8(chars, _mm_set1_epi8('\t'));
+  __m128i control = _mm_cmpeq_epi8(
+      _mm_min_epu8(offset, _mm_set1_epi8('\r' - '\t')), offset);
+  return _mm_movemask_epi8(_mm_or_si128(space, control));
+}
+
+static int IdentifierSSE2(__m128i chars) {
+  // Folding to lower case maps the upper case letters onto the lower case
+  // ones, and nothing else onto them.
+  __m128i offset = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)),
+                                _mm_set1_epi8('a'));
+  __m128i letter =
+      _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8('z' - 'a')), offset);
+  __m128i underscore = _mm_cmpeq_epi8(chars, _mm_set1_epi8('_'));
+  return _mm_movemask_epi8(_mm_or_si128(letter, underscore));
+}
+
+static int DigitsSSE2(__m128i chars) {
+  __m128i offset = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+  __m128i digit =
+      _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8('9' - '0')), offset);
+  __m128i period = _mm_cmpeq_epi8(chars, _mm_set1_epi8('.'));
+  return _mm_movemask_epi8(_mm_or_si128(digit, period));
+}
+
+// Everything but `*` and NUL, so the scan stops at candidate comment ends.
+static int CommentSSE2(__m128i chars) {
+  __m128i star = _mm_cmpeq_epi8(chars, _mm_set1_epi8('*'));
+  __m128i nul = _mm_cmpeq_epi8(chars, _mm_setzero_si128());
+  return ~_mm_movemask_epi8(_mm_or_si128(star, nul));
+}
+
+template <int (*Match)(__m128i)>
+NO_SANITIZE_ADDRESS static const char* ScanSSE2(const char* ptr) {
+  const auto addr = reinterpret_cast<uintptr_t>(ptr);
+  const auto* block = reinterpret_cast<const __m128i*>(addr & ~uintptr_t{15});
+  // Ignore the bytes of the first block that come before `ptr`.
+  unsigned stop = ~static_cast<unsigned>(Match(_mm_load_si128(block))) &
+                  (0xFFFFU << (addr & 15)) & 0xFFFFU;
+  while (stop == 0) {
+    block++;
+    stop = ~static_cast<unsigned>(Match(_mm_load_si128(block))) & 0xFFFFU;
+  }
+  return reinterpret_cast<const char*>(block) + __builtin_ctz(stop);
+}
+
+static const char* FindCommentEndSSE2(const char* ptr) {
+  while (true) {
+    ptr = ScanSSE2<CommentSSE2>(ptr);
+    if (*ptr == '\0' || ptr[1] == '/') {
+      return ptr;
+    }
+    ptr++;
+  }
+}
+
+static constexpr CharScanner sse2_scanner{
+    CharScanner::Kind::SSE2, ScanSSE2<WhitespaceSSE2>,
+    ScanSSE2<IdentifierSSE2>, ScanSSE2<DigitsSSE2>, FindCommentEndSSE2};
+
+#endif  // __SSE2__
+
+#if defined(__x86_64__)
+
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+TARGET_AVX2 static int WhitespaceAVX2(__m256i chars) {
+  __m256i space = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' '));
+  __m256i offset = _mm256_sub_epi8(chars, _mm256_set1_epi8('\t'));
+  __m256i control = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(offset, _mm256_set1_epi8('\r' - '\t')), offset);
+  return _mm256_movemask_epi8(_mm256_or_si256(space, control));
+}
+
+TARGET_AVX2 static int IdentifierAVX2(__m256i chars) {
+  __m256i offset = _mm256_sub_epi8(
+      _mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+  __m256i letter = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(offset, _mm256_set1_epi8('z' - 'a')), offset);
+  __m256i underscore = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('_'));
+  return _mm256_movemask_epi8(_mm256_or_si256(letter, underscore));
+}
+
+TARGET_AVX2 static int DigitsAVX2(__m256i chars) {
+  __m256i offset = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+  __m256i digit = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(offset, _mm256_set1_epi8('9' - '0')), offset);
+  __m256i period = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('.'));
+  return _mm256_movemask_epi8(_mm256_or_si256(digit, period));
+}
+
+TARGET_AVX2 static int CommentAVX2(__m256i chars) {
+  __m256i star = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('*'));
+  __m256i nul = _mm256_cmpeq_epi8(chars, _mm256_setzero_si256());
+  return ~_mm256_movemask_epi8(_mm256_or_si256(star, nul));
+}
+
+template <int (*Match)(__m256i)>
+TARGET_AVX2 NO_SANITIZE_ADDRESS static const char* ScanAVX2(const char* ptr) {
+  const auto addr = reinterpret_cast<uintptr_t>(ptr);
+  const auto* block = reinterpret_cast<const __m256i*>(addr & ~uintptr_t{31});
+  uint32_t stop = ~static_cast<uint32_t>(Match(_mm256_load_si256(block))) &
+                  (0xFFFFFFFFU << (addr & 31));
+  while (stop == 0) {
+    block++;
+    stop = ~static_cast<uint32_t>(Match(_mm256_load_si256(block)));
+  }
+  return reinterpret_cast<const char*>(block) + __builtin_ctz(stop);
+}
+
+TARGET_AVX2 static const char* FindCommentEndAVX2(const char* ptr) {
+  while (true) {
+    ptr = ScanAVX2<CommentAVX2>(ptr);
+    if (*ptr == '\0' || ptr[1] == '/') {
+      return ptr;
+    }
+    ptr++;
+  }
+}
+
+#undef TARGET_AVX2
+
+static constexpr CharScanner avx2_scanner{
+    CharScanner::Kind::AVX2, ScanAVX2<WhitespaceAVX2>,
+    ScanAVX2<IdentifierAVX2>, ScanAVX2<DigitsAVX2>, FindCommentEndAVX2};
+
+static bool HasAVX2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+}
+
+#endif  // __x86_64__
+
+const CharScanner* CharScanner::Get(Kind kind) {
+  switch (kind) {
+    case Kind::Scalar:
+      return &scalar_scanner;
+    case Kind::SSE2:
+#if defined(__SSE2__)
+      return &sse2_scanner;
+#else
+      return nullptr;
+#endif
+    case Kind::AVX2:
+#if defined(__x86_64__)
+      return HasAVX2() ? &avx2_scanner : nullptr;
+#else
+      return nullptr;
+#endif
+  }
+  return nullptr;
+}
+
+const CharScanner& CharScanner::Get() {
+  static const CharScanner& best = []() -> const CharScanner& {
+    for (Kind kind : {Kind::AVX2, Kind::SSE2}) {
+      if (const CharScanner* scanner = Get(kind)) {
+        return *scanner;
+      }
+    }
+    return scalar_scanner;
+  }();
+  return best;
+}
+}  // namespace jcc
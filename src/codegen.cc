@@ -1,11 +1,20 @@
 #include "jcc/codegen.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <cassert>
+#include <cerrno>
 #include <cstddef>
 #include <cstdint>
-#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <string_view>
+#include <system_error>
 
+#include "jcc/assembler.h"
+#include "jcc/casting.h"
 #include "jcc/common.h"
 #include "jcc/decl.h"
 #include "jcc/expr.h"
@@ -44,7 +53,7 @@ static int AlignTo(int n, int align) { return (n + align - 1) / align * align; }
 
 static void AssignLocalOffsets(const std::vector<Decl*>& decls) {
   for (Decl* decl : decls) {
-    if (auto* func = decl->As<FunctionDecl>(); func != nullptr) {
+    if (auto* func = dyn_cast<FunctionDecl>(decl); func != nullptr) {
       // If a function has many parameters, some parameters are
       // inevitably passed by stack rather than by register.
       // The first passed-by-stack parameter resides at RBP+16.
@@ -98,7 +107,7 @@ static void AssignLocalOffsets(const std::vector<Decl*>& decls) {
 
       for (const auto& local : func->GetLocals()) {
         // Is this check really needed?
-        if (auto* var_decl = local->As<VarDecl>(); var_decl != nullptr) {
+        if (auto* var_decl = dyn_cast<VarDecl>(local); var_decl != nullptr) {
           set_offset(var_decl);
         }
       }
@@ -116,37 +125,108 @@ static void AssignLocalOffsets(const std::vector<Decl*>& decls) {
   }
 }
 
+static void Generate(CodeGen& generator, const std::vector<Decl*>& decls) {
+  AssignLocalOffsets(decls);
+  for (Decl* decl : decls) {
+    generator.Visit(decl);
+    generator.Flush();
+  }
+}
+
 void GenerateAssembly(const std::string& file_name,
                       const std::vector<jcc::Decl*>& decls) {
   CodeGen generator(file_name);
-  AssignLocalOffsets(decls);
-  for (Decl* decl : decls) {
-    decl->GenCode(generator);
+  Generate(generator, decls);
+}
+
+void GenerateAssembly(const std::string& file_name, int fd,
+                      const std::vector<jcc::Decl*>& decls) {
+  CodeGen generator(file_name, fd);
+  Generate(generator, decls);
+}
+
+static int OpenOutputFile(const std::string& name) {
+  int fd = open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    fmt::print(stderr, "Can't open {}: {}!\n", name, std::strerror(errno));
+    std::exit(-1);
+  }
+  return fd;
+}
+
+void GenerateObject(const std::string& file_name,
+                    const std::string& object_name,
+                    const std::vector<jcc::Decl*>& decls) {
+  AsmBuffer buffer;
+  WriteElf(GenerateObjectInMemory(file_name, decls), buffer);
+  int fd = OpenOutputFile(object_name);
+  if (!buffer.Drain(fd)) {
+    fmt::print(stderr, "Can't write {}: {}!\n", object_name,
+               std::strerror(errno));
+    std::exit(-1);
   }
+  close(fd);
+}
+
+ObjectFile GenerateObjectInMemory(const std::string& file_name,
+                                  const std::vector<jcc::Decl*>& decls) {
+  Assembler assembler;
+  {
+    CodeGen generator(file_name, assembler);
+    Generate(generator, decls);
+  }
+  return assembler.Finish();
+}
+
+// The directory of the assembly file.
+static std::string GetAsmDir(const std::string& name) {
+  std::filesystem::path dir = std::filesystem::path(name).parent_path();
+  return dir.empty() ? "." : dir.string();
 }
 
 CodeGen::CodeGen(const std::string& file_name)
-    : name_(CreateAsmFileName(file_name)) {
+    : name_(CreateAsmFileName(file_name)),
+      fd_(OpenOutputFile(name_)),
+      out_(fd_, GetAsmDir(name_)) {
   EmitSectionRAII section_guard(*this, Section::Header);
-  Writeln(R"(  .file "{}")", file_name);
+  out_.Directive(R"(.file "{}")", file_name);
+}
+
+// Data is spilled to the temporary directory when there's no assembly file
+// to keep it company.
+static std::string GetTempDir() {
+  std::error_code error;
+  std::filesystem::path dir = std::filesystem::temp_directory_path(error);
+  return error ? "/tmp" : dir.string();
+}
+
+CodeGen::CodeGen(const std::string& file_name, int fd)
+    : fd_(-1), out_(fd, GetTempDir()) {
+  EmitSectionRAII section_guard(*this, Section::Header);
+  out_.Directive(R"(.file "{}")", file_name);
+}
+
+CodeGen::CodeGen(const std::string& file_name, Assembler& assembler)
+    : fd_(-1), out_(assembler) {
+  EmitSectionRAII section_guard(*this, Section::Header);
+  out_.Directive(R"(.file "{}")", file_name);
 }
 
 CodeGen::~CodeGen() {
-  std::fstream out(name_, std::ios::out | std::ios::trunc);
-  out << header_;
-  out << data_;
-  out << text_;
-  out.close();
+  out_.Finish();
+  if (fd_ >= 0) {
+    close(fd_);
+  }
 }
 
 void CodeGen::Store(const Type& type) {
   Pop("%rdi");
   switch (type.GetKind()) {
     case TypeKind::Int:
-      Writeln("  mov %eax, (%rdi)");
+      out_.Instr("mov %eax, (%rdi)");
       break;
     default:
-      Writeln("  mov %rax, (%rdi)");
+      out_.Instr("mov %rax, (%rdi)");
       // jcc_unimplemented();
   }
 }
@@ -154,10 +234,10 @@ void CodeGen::Store(const Type& type) {
 void CodeGen::Load(const Type& type) {
   switch (type.GetSize()) {
     case 4:
-      Writeln("  movsxd (%rax), %rax");
+      out_.Instr("movsxd (%rax), %rax");
       break;
     default:
-      Writeln("  mov (%rax), %rax");
+      out_.Instr("mov (%rax), %rax");
   }
 }
 
@@ -171,9 +251,9 @@ void CodeGen::Assign(Decl& decl, Stmt* init) {
     assert(!ctx.cur_func_name.empty() &&
            "We're not inside a funtion? You sure it's a local decl?");
 
-    Writeln("  lea {}(%rbp), %rax", *offset);
+    out_.Instr("lea {}(%rbp), %rax", *offset);
     Push();
-    init->GenCode(*this);
+    Visit(init);
     Store(*decl.GetType());
   } else {
     jcc_unimplemented();
@@ -186,7 +266,7 @@ void CodeGen::Assign(Decl& decl, Stmt* init) {
 //   3. rax = real value like `42`.
 //   4. pop the address of the decl and assign it to rdi.
 //   5. *rdi = rax, which is the real value.
-void CodeGen::EmitVarDecl(VarDecl& decl) { Assign(decl, decl.GetInit()); }
+void CodeGen::VisitVarDecl(VarDecl& decl) { Assign(decl, decl.GetInit()); }
 
 void CodeGen::StoreArgs(FunctionDecl& func) {
   for (size_t i = 0; i < func.GetParamNum(); ++i) {
@@ -197,7 +277,7 @@ void CodeGen::StoreArgs(FunctionDecl& func) {
     switch (arg->GetType()->GetSize()) {
       case 4: {
         if (std::optional<int> offset = arg->GetOffset()) {
-          Writeln("  mov {}, {}(%rbp)", arg_reg32[i], *offset);
+          out_.Instr("mov {}, {}(%rbp)", arg_reg32[i], *offset);
           break;
         }
         jcc_unimplemented();
@@ -208,7 +288,7 @@ void CodeGen::StoreArgs(FunctionDecl& func) {
   }
 }
 
-void CodeGen::EmitFunctionDecl(FunctionDecl& decl) {
+void CodeGen::VisitFunctionDecl(FunctionDecl& decl) {
   // Just a declaration, no need to emit code.
   if (!decl.HasDefinition()) {
     return;
@@ -219,203 +299,202 @@ void CodeGen::EmitFunctionDecl(FunctionDecl& decl) {
   ctx.cur_func_name = decl.GetName();
 
   if (decl.GetType()->IsStatic()) {
-    Writeln("  .local {}", decl.GetName());
+    out_.Directive(".local {}", decl.GetName());
   } else {
-    Writeln("  .globl {}", decl.GetName());
+    out_.Directive(".globl {}", decl.GetName());
   }
 
-  Writeln("  .type {}, @function", decl.GetName());
-  Writeln("  .text");
-  Writeln("{}:", decl.GetName());
+  out_.Directive(".type {}, @function", decl.GetName());
+  out_.Directive(".text");
+  out_.Label("{}", decl.GetName());
 
   EmitFunctionRAII emit_func_guard(*this);
 
   // Allocate stack for the function.
   // FIXME: these're just arbitrary numbers.
-  Writeln("  sub ${}, %rsp", decl.GetStackSize());
+  out_.Instr("sub ${}, %rsp", decl.GetStackSize());
   // Handle varidic function.
 
   // Save passed by regisiter arguments.
   StoreArgs(decl);
 
   // Emit code for body.
-  decl.GetBody()->GenCode(*this);
+  Visit(decl.GetBody());
 
   // Section for ret.
   if (decl.IsMain()) {
-    Writeln("  mov $0, %rax");
+    out_.Instr("mov $0, %rax");
   }
-  Writeln(".L.return.{}:", decl.GetName());
+  out_.Label(".L.return.{}", decl.GetName());
 }
 
-void CodeGen::EmitRecordDecl(RecordDecl& decl) {}
+void CodeGen::VisitRecordDecl(RecordDecl& decl) {}
 
 void CodeGen::CompZero(const Type& type) {
   if (type.IsInteger()) {
     const char* instr = type.GetSize() <= 4 ? "%eax" : "%rax";
-    Writeln("  cmp $0, {}", instr);
+    out_.Instr("cmp $0, {}", instr);
     return;
   }
   jcc_unimplemented();
 }
 
-void CodeGen::EmitIfStatement(IfStatement& stmt) {
+void CodeGen::VisitIfStatement(IfStatement& stmt) {
   int64_t section_cnt = Counter();
-  stmt.GetCondition()->GenCode(*this);
+  Visit(stmt.GetCondition());
   CompZero(*stmt.GetCondition()->GetType());
-  Writeln("  je  .L.else.{}", section_cnt);
-  stmt.GetThen()->GenCode(*this);
-  Writeln("  jmp .L.end.{}", section_cnt);
-  Writeln(".L.else.{}:", section_cnt);
+  out_.Instr("je  .L.else.{}", section_cnt);
+  Visit(stmt.GetThen());
+  out_.Instr("jmp .L.end.{}", section_cnt);
+  out_.Label(".L.else.{}", section_cnt);
   if (auto* else_stmt = stmt.GetElse()) {
-    else_stmt->GenCode(*this);
+    Visit(else_stmt);
   }
-  Writeln(".L.end.{}:", section_cnt);
+  out_.Label(".L.end.{}", section_cnt);
 }
 
-void CodeGen::EmitWhileStatement(WhileStatement& stmt) {
+void CodeGen::VisitWhileStatement(WhileStatement& stmt) {
   int64_t section_cnt = Counter();
-  Writeln(".L.begin.{}:", section_cnt);
+  out_.Label(".L.begin.{}", section_cnt);
   if (auto* cond = stmt.GetCondition()) {
-    cond->GenCode(*this);
+    Visit(cond);
     CompZero(*cond->GetType());
   }
-  Writeln("  je .L.body.{}", section_cnt);
-  stmt.GetBody()->GenCode(*this);
-  Writeln("  jmp .L.begin.{}", section_cnt);
-  Writeln(".L.body.{}:", section_cnt);
+  out_.Instr("je .L.body.{}", section_cnt);
+  Visit(stmt.GetBody());
+  out_.Instr("jmp .L.begin.{}", section_cnt);
+  out_.Label(".L.body.{}", section_cnt);
 }
 
-void CodeGen::EmitDoStatement(DoStatement& stmt) {
+void CodeGen::VisitDoStatement(DoStatement& stmt) {
   int64_t section_cnt = Counter();
-  Writeln(".L.begin.{}:", section_cnt);
-  stmt.GetBody()->GenCode(*this);
-  stmt.GetCondition()->GenCode(*this);
-  Writeln("  jne .L.begin.{}", section_cnt);
+  out_.Label(".L.begin.{}", section_cnt);
+  Visit(stmt.GetBody());
+  Visit(stmt.GetCondition());
+  out_.Instr("jne .L.begin.{}", section_cnt);
 }
 
 // TODO(Jun): Support continue and break statements.
-void CodeGen::EmitForStatement(ForStatement& stmt) {
+void CodeGen::VisitForStatement(ForStatement& stmt) {
   int64_t section_cnt = Counter();
   if (auto* init = stmt.GetInit()) {
-    init->GenCode(*this);
+    Visit(init);
   }
-  Writeln(".L.begin.{}:", section_cnt);
+  out_.Label(".L.begin.{}", section_cnt);
   if (Stmt* condition = stmt.GetCondition()) {
-    condition->GenCode(*this);
+    Visit(condition);
     // FIXME: WE should really reevaluate it the relationship between stmt and
     // expr.
-    if (auto* cond_expr = condition->As<ExprStatement>();
+    if (auto* cond_expr = dyn_cast<ExprStatement>(condition);
         cond_expr != nullptr) {
       CompZero(*cond_expr->GetExpr()->GetType());
     } else {
       jcc_unreachable("Condition should has a expr!");
     }
-    Writeln("  je .L.end.{}", section_cnt);
+    out_.Instr("je .L.end.{}", section_cnt);
   }
-  stmt.GetBody()->GenCode(*this);
+  Visit(stmt.GetBody());
   if (Stmt* inc = stmt.GetIncrement()) {
-    inc->GenCode(*this);
+    Visit(inc);
   }
-  Writeln("  jmp .L.begin.{}", section_cnt);
-  Writeln(".L.end.{}:", section_cnt);
+  out_.Instr("jmp .L.begin.{}", section_cnt);
+  out_.Label(".L.end.{}", section_cnt);
 }
 
-void CodeGen::EmitSwitchStatement(SwitchStatement& stmt) {
+void CodeGen::VisitSwitchStatement(SwitchStatement& stmt) {
   Expr* condition = stmt.GetCondition();
   CaseStatement* default_stmt = nullptr;
 
-  condition->GenCode(*this);
+  Visit(condition);
 
   const char* instr = condition->GetType()->GetSize() == 8 ? "%rax" : "%eax";
 
   for (size_t i = 0; i < stmt.GetSize(); ++i) {
-    auto* case_stmt = stmt.GetStmt(i)->As<CaseStatement>();
-    case_stmt->SetLabel(fmt::format(".L..{}", Counter()));
+    auto* case_stmt = cast<CaseStatement>(stmt.GetStmt(i));
+    case_stmt->SetLabel(Counter());
     if (case_stmt->IsDefault()) {
       default_stmt = case_stmt;
     } else {
-      Writeln("  cmp ${}, {}", case_stmt->GetValue(), instr);
-      Writeln("  je {}", case_stmt->GetLabel());
+      out_.Instr("cmp ${}, {}", case_stmt->GetValue(), instr);
+      out_.Instr("je .L..{}", case_stmt->GetLabel());
     }
   }
   if (default_stmt != nullptr) {
-    Writeln("  jmp {}", default_stmt->GetLabel());
+    out_.Instr("jmp .L..{}", default_stmt->GetLabel());
   }
 
   for (size_t i = 0; i < stmt.GetSize(); ++i) {
-    stmt.GetStmt(i)->GenCode(*this);
+    Visit(stmt.GetStmt(i));
   }
 }
 
-void CodeGen::EmitCaseStatement(CaseStatement& stmt) {
-  Writeln("{}:", stmt.GetLabel());
-  stmt.GetStmt()->GenCode(*this);
+void CodeGen::VisitCaseStatement(CaseStatement& stmt) {
+  out_.Label(".L..{}", stmt.GetLabel());
+  Visit(stmt.GetStmt());
 }
 
-void CodeGen::EmitReturnStatement(ReturnStatement& stmt) {
+void CodeGen::VisitReturnStatement(ReturnStatement& stmt) {
   if (auto* return_expr = stmt.GetReturn()) {
-    return_expr->GenCode(*this);
+    Visit(return_expr);
     if (!return_expr->GetType()->IsInteger()) {
       jcc_unimplemented();
     }
-    Writeln("  jmp .L.return.{}", ctx.cur_func_name);
+    out_.Instr("jmp .L.return.{}", ctx.cur_func_name);
   }
 }
 
-void CodeGen::EmitBreakStatement(BreakStatement& stmt) {}
+void CodeGen::VisitBreakStatement(BreakStatement& stmt) {}
 
-void CodeGen::EmitContinueStatement(ContinueStatement& stmt) {}
+void CodeGen::VisitContinueStatement(ContinueStatement& stmt) {}
 
-void CodeGen::EmitDeclStatement(DeclStatement& stmt) {
+void CodeGen::VisitDeclStatement(DeclStatement& stmt) {
   for (auto* decl : stmt.GetDecls()) {
-    decl->GenCode(*this);
+    Visit(decl);
   }
 }
 
-void CodeGen::EmitExprStatement(ExprStatement& stmt) {
-  stmt.GetExpr()->GenCode(*this);
+void CodeGen::VisitExprStatement(ExprStatement& stmt) {
+  Visit(stmt.GetExpr());
 }
 
-void CodeGen::EmitCompoundStatement(CompoundStatement& stmt) {
+void CodeGen::VisitCompoundStatement(CompoundStatement& stmt) {
   for (std::size_t idx = 0; idx < stmt.GetSize(); idx++) {
-    stmt.GetStmt(idx)->GenCode(*this);
+    Visit(stmt.GetStmt(idx));
   }
 }
 
-void CodeGen::EmitStringLiteral(StringLiteral& expr) {
-  // Include the null terminator.
-  size_t size = expr.GetValue().size() + 1;
-  std::string name = fmt::format(".L..{}", Counter());
-  std::string value = expr.GetValue();
+void CodeGen::VisitStringLiteral(StringLiteral& expr) {
+  std::string_view value = expr.GetValue();
+  const int64_t label = Counter();
   {
     EmitSectionRAII section_guard(*this, Section::Data);
 
-    Writeln("  .local {}", name);
+    out_.Directive(".local .L..{}", label);
     // TODO(Jun): Support .tdata
-    Writeln("  .data");
-    Writeln("  .type {}, @object", name);
-    Writeln("  .size {}, {}", name, size);
+    out_.Directive(".data");
+    out_.Directive(".type .L..{}, @object", label);
+    // Include the null terminator.
+    out_.Directive(".size .L..{}, {}", label, value.size() + 1);
     // FIXME: What's the type of the StringLiteral?
-    Writeln("  .align {}", 1);
-    Writeln("{}:", name);
-    for (size_t i = 0; i < size; ++i) {
-      Writeln("  .byte {}", static_cast<int>(value[i]));
+    out_.Directive(".align {}", 1);
+    out_.Label(".L..{}", label);
+    for (char c : value) {
+      out_.Directive(".byte {}", static_cast<int>(c));
     }
+    out_.Directive(".byte 0");
   }
-  Writeln("  lea {}(%rip), %rax", name);
+  out_.Instr("lea .L..{}(%rip), %rax", label);
 }
 
-void CodeGen::EmitCharacterLiteral(CharacterLiteral& expr) {
-  assert(expr.GetValue().size() == 1 && "Not a character?");
-  Writeln("  mov {}, %rax", static_cast<int>(expr.GetValue()[0]));
+void CodeGen::VisitCharacterLiteral(CharacterLiteral& expr) {
+  out_.Instr("mov ${}, %rax", static_cast<int>(expr.GetValue()));
 }
 
-void CodeGen::EmitIntergerLiteral(IntergerLiteral& expr) {
-  Writeln("  mov ${}, %rax", expr.GetValue());
+void CodeGen::VisitIntergerLiteral(IntergerLiteral& expr) {
+  out_.Instr("mov ${}, %rax", expr.GetValue());
 }
 
-void CodeGen::EmitFloatingLiteral(FloatingLiteral& expr) {}
+void CodeGen::VisitFloatingLiteral(FloatingLiteral& expr) {}
 
 void CodeGen::PushArgs(CallExpr& expr) {
   std::vector<bool> pass_by_stack(expr.GetArgNum(), false);
@@ -441,13 +520,13 @@ void CodeGen::PushArgs(CallExpr& expr) {
     }
   }
   if ((stack + StackDepthTracker::Get()) % 2 == 1) {
-    Writeln("  sub $8, %rsp");
+    out_.Instr("sub $8, %rsp");
     StackDepthTracker::Push();
     stack++;
   }
   for (int j = expr.GetArgNum() - 1; j >= 0; --j) {
     Expr* arg = expr.GetArg(j);
-    arg->GenCode(*this);
+    Visit(arg);
     bool not_impl = arg->GetType()
                         ->IsOneOf<TypeKind::Struct, TypeKind::Union,
                                   TypeKind::Float, TypeKind::Double>();
@@ -473,33 +552,33 @@ void CodeGen::PopArgs(CallExpr& expr) {
   }
 }
 
-void CodeGen::EmitCallExpr(CallExpr& expr) {
-  auto* func =
-      expr.GetCallee()->As<DeclRefExpr>()->GetRefDecl()->As<FunctionDecl>();
+void CodeGen::VisitCallExpr(CallExpr& expr) {
+  auto* func = cast<FunctionDecl>(
+      cast<DeclRefExpr>(expr.GetCallee())->GetRefDecl());
 
   PushArgs(expr);
 
   if (func->HasDefinition()) {
-    Writeln("  lea {}(%rip), %rax", func->GetName());
+    out_.Instr("lea {}(%rip), %rax", func->GetName());
   } else {
-    Writeln("  mov {}@GOTPCREL(%rip), %rax", func->GetName());
+    out_.Instr("mov {}@GOTPCREL(%rip), %rax", func->GetName());
   }
 
   PopArgs(expr);
 
-  Writeln("  mov %rax, %r10");
-  Writeln("  mov $0, %rax");
-  Writeln("  call *%r10");
-  Writeln("  add $0, %rsp");
+  out_.Instr("mov %rax, %r10");
+  out_.Instr("mov $0, %rax");
+  out_.Instr("call *%r10");
+  out_.Instr("add $0, %rsp");
 }
 
-void CodeGen::EmitUnaryExpr(UnaryExpr& expr) {
-  expr.GetValue()->GenCode(*this);
+void CodeGen::VisitUnaryExpr(UnaryExpr& expr) {
+  Visit(expr.GetValue());
   switch (expr.getKind()) {
     case UnaryOperatorKind::PostIncrement: {
-      if (auto* ref_expr = expr.GetValue()->As<DeclRefExpr>();
+      if (auto* ref_expr = cast<DeclRefExpr>(expr.GetValue());
           ref_expr->GetRefDecl()->GetType()->GetSize() == 4) {
-        Writeln("  addl $1, {}(%rbp)", *ref_expr->GetRefDecl()->GetOffset());
+        out_.Instr("addl $1, {}(%rbp)", *ref_expr->GetRefDecl()->GetOffset());
       } else {
         jcc_unimplemented();
       }
@@ -510,7 +589,7 @@ void CodeGen::EmitUnaryExpr(UnaryExpr& expr) {
   }
 }
 
-void CodeGen::EmitBinaryExpr(BinaryExpr& expr) {
+void CodeGen::VisitBinaryExpr(BinaryExpr& expr) {
   using enum BinaryOperatorKind;
   switch (expr.GetKind()) {
     case Greater:
@@ -519,22 +598,22 @@ void CodeGen::EmitBinaryExpr(BinaryExpr& expr) {
       Expr* lhs = expr.GetKind() == Greater ? expr.GetLhs() : expr.GetRhs();
       Expr* rhs = expr.GetKind() == Greater ? expr.GetRhs() : expr.GetLhs();
       // Store lhs and rhs to rdi and rax respectively.
-      lhs->GenCode(*this);
+      Visit(lhs);
       Push();
-      rhs->GenCode(*this);
+      Visit(rhs);
       Pop("%rdi");
       // FIXME: Register size!
       assert(expr.GetLhs()->GetType()->GetSize() == 4);
-      Writeln("  cmp {}, {}", "%edi", "%eax");
+      out_.Instr("cmp {}, {}", "%edi", "%eax");
       const char* instr =
           expr.GetLhs()->GetType()->IsUnsigned() ? "setb" : "setl";
-      Writeln("  {} %al", instr);
-      Writeln("  movzb %al, %rax");
+      out_.Instr("{} %al", instr);
+      out_.Instr("movzb %al, %rax");
       break;
     }
     case Equal: {
-      // Can't invoke `EmitDeclRefExpr` as it will call `Load`
-      auto* ref_expr = expr.GetLhs()->As<DeclRefExpr>();
+      // Can't invoke `VisitDeclRefExpr` as it will call `Load`
+      auto* ref_expr = dyn_cast<DeclRefExpr>(expr.GetLhs());
       assert(ref_expr != nullptr &&
              "The Lhs of the BinaryExpr is not a DeclRefExpr?");
       Assign(*ref_expr->GetRefDecl(), expr.GetRhs());
@@ -544,11 +623,11 @@ void CodeGen::EmitBinaryExpr(BinaryExpr& expr) {
       jcc_unimplemented();
     }
     case Plus: {
-      expr.GetLhs()->GenCode(*this);
+      Visit(expr.GetLhs());
       Push();
-      expr.GetRhs()->GenCode(*this);
+      Visit(expr.GetRhs());
       Pop("%rdi");
-      Writeln("  add {}, {}", "%edi", "%eax");
+      out_.Instr("add {}, {}", "%edi", "%eax");
       break;
     }
     default:
@@ -556,13 +635,13 @@ void CodeGen::EmitBinaryExpr(BinaryExpr& expr) {
   }
 }
 
-void CodeGen::EmitArraySubscriptExpr(ArraySubscriptExpr& expr) {}
+void CodeGen::VisitArraySubscriptExpr(ArraySubscriptExpr& expr) {}
 
-void CodeGen::EmitMemberExpr(MemberExpr& expr) {}
+void CodeGen::VisitMemberExpr(MemberExpr& expr) {}
 
-void CodeGen::EmitDeclRefExpr(DeclRefExpr& expr) {
+void CodeGen::VisitDeclRefExpr(DeclRefExpr& expr) {
   if (std::optional<int> offset = expr.GetRefDecl()->GetOffset()) {
-    Writeln("  lea {}(%rbp), %rax", *offset);
+    out_.Instr("lea {}(%rbp), %rax", *offset);
 
     // TODO(Jun): Implement cases when we have char or double types and etc.
     // const char* instr = type->IsUnsigned() ? "movz" : "mos";
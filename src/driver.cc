@@ -1,5 +1,6 @@
 #include "jcc/driver.h"
 
+#include <fcntl.h>
 #include <fmt/format.h>
 #include <unistd.h>
 #include <wait.h>
@@ -8,45 +9,94 @@
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
-#include <fstream>
+#include <memory>
 #include <optional>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include "jcc/ast_dumper.h"
 #include "jcc/codegen.h"
 #include "jcc/decl.h"
+#include "jcc/identifier_table.h"
+#include "jcc/jit.h"
 #include "jcc/lexer.h"
+#include "jcc/memory_buffer.h"
 #include "jcc/parser.h"
+#include "jcc/source_manager.h"
+#include "jcc/token_buffer.h"
 
-static std::optional<std::string> ReadFile(std::string_view name) {
-  std::ifstream file{name.data()};
-  std::string contents{std::istreambuf_iterator<char>(file),
-                       std::istreambuf_iterator<char>()};
-  if (contents.empty()) {
-    return std::nullopt;
+// Starts a new command. Given `in`, its stdin is a pipe, and `in` is set to
+// the end to write to.
+static pid_t StartSubprocess(char** argv, int* in = nullptr) {
+  int pipe_fds[2];
+  if (in != nullptr && pipe2(pipe_fds, O_CLOEXEC) < 0) {
+    fprintf(stderr, "pipe failed: %s\n", strerror(errno));
+    exit(1);
   }
-  return contents;
-}
-
-static void RunSubprocess(char** argv) {
-  if (fork() == 0) {
+  pid_t pid = fork();
+  if (pid == 0) {
     // Child process. Run a new command.
+    if (in != nullptr) {
+      dup2(pipe_fds[0], STDIN_FILENO);
+    }
     execvp(argv[0], argv);
     fprintf(stderr, "exec failed: %s: %s\n", argv[0], strerror(errno));
     _exit(1);
   }
-  // Wait for the child process to finish.
-  int status;
-  while (wait(&status) > 0) {
-    // keep spinning after the child process is finished.
+  if (in != nullptr) {
+    close(pipe_fds[0]);
+    // A bigger pipe means fewer trips back and forth between the two.
+    fcntl(pipe_fds[1], F_SETPIPE_SZ, 1024 * 1024);
+    *in = pipe_fds[1];
+  }
+  return pid;
+}
+
+static void WaitSubprocess(pid_t pid) {
+  int status = 0;
+  while (waitpid(pid, &status, 0) < 0) {
+    // Interrupted before the child process finished.
+    if (errno != EINTR) {
+      fprintf(stderr, "wait failed: %s\n", strerror(errno));
+      exit(1);
+    }
   }
   if (status != 0) {
     exit(1);
   }
 }
 
+static void RunSubprocess(char** argv) {
+  WaitSubprocess(StartSubprocess(argv));
+}
+
+// Loads `object` into this process and calls its main function, no linker
+// involved. Returns what main returns.
+static int RunInMemory(const jcc::ObjectFile& object,
+                       const std::vector<std::string>& args) {
+  std::unique_ptr<jcc::JitImage> image = jcc::JitImage::Load(object);
+  if (image == nullptr) {
+    exit(-1);
+  }
+  using MainFunc = int (*)(int, char**, char**);
+  auto main_func = reinterpret_cast<MainFunc>(image->GetSymbol("main"));
+  if (main_func == nullptr) {
+    fmt::print("No main function to run!\n");
+    exit(-1);
+  }
+  std::vector<char*> argv;
+  for (const std::string& arg : args) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+  return main_func(static_cast<int>(args.size()), argv.data(), environ);
+}
+
 static std::filesystem::path GetSourceFile(std::string_view name) {
   std::filesystem::path file(name);
-  if (!std::filesystem::exists(file)) {
+  // "-" stands for stdin.
+  if (name != "-" && !std::filesystem::exists(file)) {
     fmt::print("No such source file: {}!", name);
   }
   return file;
@@ -74,6 +124,8 @@ Driver::Driver(int argc, char** argv) {
     }
     return true;
   };
+  // Unless it's given, it depends on -pipe.
+  std::optional<bool> integrated_as;
 
   while (iter != end) {
     if (*iter == "-o") {
@@ -89,57 +141,128 @@ Driver::Driver(int argc, char** argv) {
       opt_c_ = true;
     } else if (*iter == "--ast-dump") {
       ast_dump_ = true;
-    } else if (iter->starts_with("-")) {
+    } else if (*iter == "--lex-all") {
+      lex_all_ = true;
+    } else if (*iter == "--pipeline-threads") {
+      pipeline_threads_ = true;
+    } else if (*iter == "-fintegrated-as") {
+      integrated_as = true;
+    } else if (*iter == "-fno-integrated-as") {
+      integrated_as = false;
+    } else if (*iter == "-pipe") {
+      pipe_ = true;
+    } else if (*iter == "--run") {
+      run_ = true;
+    } else if (iter->starts_with("-") && *iter != "-") {
       fmt::print("Unknown argument: {}!\n", *iter);
     } else {
       source_file_ = GetSourceFile(*iter);
+      // The rest are for the program.
+      if (run_) {
+        run_args_.assign(iter, end);
+        break;
+      }
     }
     ++iter;
   }
+
+  // -pipe is about feeding `as`, so it implies -fno-integrated-as, unless
+  // the integrated assembler is asked for.
+  integrated_as_ = integrated_as.value_or(!pipe_);
+  if (integrated_as_ && pipe_) {
+    fmt::print("-pipe has no effect with the integrated assembler!\n");
+  }
 }
 
-void Driver::Run() {
+int Driver::Run() {
   std::string source_file = GetSourceName();
-  std::optional<std::string> contents = ReadFile(source_file);
-  if (!contents.has_value()) {
+  std::unique_ptr<MemoryBuffer> contents =
+      source_file_ == "-" ? MemoryBuffer::GetSTDIN()
+                          : MemoryBuffer::GetFile(source_file);
+  if (contents == nullptr) {
     fmt::print("No such source file: {}!\n", source_file);
     exit(-1);
   }
 
   if (ast_dump_) {
-    Assemble(*contents, GetSourceName(), /*ast-dump*/ true);
-    return;
+    return Assemble(contents->GetBuffer(), GetSourceName(), Output::ASTDump);
   }
   // Only compile to assembly file.
   if (opt_s_) {
-    Assemble(*contents, GetSourceName());
-    return;
+    return Assemble(contents->GetBuffer(), GetSourceName(), Output::Assembly);
+  }
+  if (run_) {
+    return Assemble(contents->GetBuffer(), GetSourceName(), Output::Run);
+  }
+  // Without the integrated assembler, the object file takes a detour
+  // through `as`, fed an assembly file or a pipe.
+  if (integrated_as_) {
+    Assemble(contents->GetBuffer(), GetSourceName(), Output::Object);
+  } else if (pipe_) {
+    Assemble(contents->GetBuffer(), GetSourceName(), Output::PipedAssembly);
+  } else {
+    Assemble(contents->GetBuffer(), GetSourceName(), Output::Assembly);
+    Compile();
   }
   // Only compile to object file.
   if (opt_c_) {
-    Assemble(*contents, GetSourceName());
-    Compile();
-    return;
+    return 0;
   }
   // Or we just compile it to an executable.
-  Assemble(*contents, GetSourceName());
-  Compile();
   Link();
+  return 0;
 }
 
-// Turn prog.c => prog.s
-void Driver::Assemble(const std::string& content,
-                      const std::string& source_file, bool ast_dump) {
-  Lexer lexer(content, source_file);
-  Parser parser(lexer);
+// Turn prog.c => prog.s, or prog.o with the integrated assembler.
+int Driver::Assemble(std::string_view content, const std::string& source_file,
+                     Output output) {
+  SourceManager source_mgr;
+  IdentifierTable idents;
+  Lexer lexer(source_mgr, source_mgr.AddBuffer(source_file, content), idents);
+  std::optional<TokenBuffer> tokens;
+  std::optional<TokenQueue> queue;
+  // Declared after the queue, so it's joined before the queue goes away.
+  std::jthread lexer_thread;
+  if (pipeline_threads_) {
+    queue.emplace();
+    lexer_thread = std::jthread([&] { lexer.LexAll(*queue); });
+  } else if (lex_all_) {
+    tokens = lexer.LexAll();
+  }
+  Parser parser = queue    ? Parser(lexer, *queue)
+                  : tokens ? Parser(lexer, *tokens)
+                           : Parser(lexer);
   std::vector<Decl*> decls = parser.ParseTranslateUnit();
-  if (!ast_dump) {
-    GenerateAssembly(source_file, decls);
-  } else {
-    for (const Decl* decl : decls) {
-      decl->dump(0);
+  switch (output) {
+    case Output::ASTDump: {
+      ASTDumper dumper;
+      for (Decl* decl : decls) {
+        dumper.Visit(decl);
+      }
+      break;
+    }
+    case Output::Assembly:
+      GenerateAssembly(source_file, decls);
+      break;
+    case Output::PipedAssembly: {
+      // `as` gets going on the code while the rest is still generated.
+      std::string obj_file = GetObjectName();
+      const char* cmd[] = {"as", "-c", "-o", obj_file.c_str(), nullptr};
+      int fd;
+      pid_t pid = StartSubprocess(const_cast<char**>(cmd), &fd);
+      GenerateAssembly(source_file, fd, decls);
+      close(fd);
+      WaitSubprocess(pid);
+      break;
     }
+    case Output::Object:
+      GenerateObject(source_file, GetObjectName(), decls);
+      break;
+    case Output::Run:
+      return RunInMemory(GenerateObjectInMemory(source_file, decls),
+                         run_args_);
   }
+  return 0;
 }
 
 // Turn prog.s => prog.o
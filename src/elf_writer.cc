@@ -0,0 +1,178 @@
+#include "jcc/elf_writer.h"
+
+#include <elf.h>
+
+#include <cstring>
+#include <string_view>
+
+#include "jcc/asm_writer.h"
+
+namespace jcc {
+
+namespace {
+
+class StringTable {
+  std::string data_ = std::string(1, '\0');
+
+ public:
+  std::uint32_t Add(std::string_view str) {
+    if (str.empty()) {
+      return 0;
+    }
+    const auto offset = static_cast<std::uint32_t>(data_.size());
+    data_ += str;
+    data_ += '\0';
+    return offset;
+  }
+
+  [[nodiscard]] std::string_view GetData() const { return data_; }
+};
+
+template <typename T>
+std::string_view Bytes(const T& value) {
+  return {reinterpret_cast<const char*>(&value), sizeof(T)};
+}
+
+// The contents of a section, at its offset in the file.
+struct Piece {
+  std::string_view data;
+  std::uint64_t offset;
+};
+
+}  // namespace
+
+void WriteElf(const ObjectFile& object, AsmBuffer& out) {
+  StringTable names;
+  StringTable strings;
+  std::vector<Elf64_Shdr> headers(1);
+  std::vector<Piece> pieces;
+  std::uint64_t offset = sizeof(Elf64_Ehdr);
+
+  auto add_section = [&](std::string_view name, std::uint32_t type,
+                         std::uint64_t flags, std::uint64_t alignment,
+                         std::string_view data) {
+    offset = (offset + alignment - 1) / alignment * alignment;
+    Elf64_Shdr header{};
+    header.sh_name = names.Add(name);
+    header.sh_type = type;
+    header.sh_flags = flags;
+    header.sh_offset = offset;
+    header.sh_size = data.size();
+    header.sh_addralign = alignment;
+    headers.push_back(header);
+    pieces.push_back({data, offset});
+    offset += data.size();
+    return &headers.back();
+  };
+
+  for (const ObjectSection& section : object.sections) {
+    add_section(section.name, section.type, section.flags, section.alignment,
+                section.data);
+  }
+
+  // Local symbols have to come first, sh_info of the symbol table tells
+  // where the global ones start.
+  std::vector<std::size_t> symbol_index(object.symbols.size());
+  std::vector<Elf64_Sym> symbols(1);
+  for (int global = 0; global < 2; global++) {
+    for (std::size_t i = 0; i < object.symbols.size(); i++) {
+      const ObjectSymbol& symbol = object.symbols[i];
+      if ((symbol.binding != STB_LOCAL) != static_cast<bool>(global)) {
+        continue;
+      }
+      symbol_index[i] = symbols.size();
+      Elf64_Sym sym{};
+      sym.st_name = strings.Add(symbol.name);
+      sym.st_info = ELF64_ST_INFO(symbol.binding, symbol.type);
+      sym.st_shndx = symbol.section;
+      sym.st_value = symbol.value;
+      sym.st_size = symbol.size;
+      symbols.push_back(sym);
+    }
+  }
+  std::uint32_t first_global = symbols.size();
+  for (std::size_t i = 1; i < symbols.size(); i++) {
+    if (ELF64_ST_BIND(symbols[i].st_info) != STB_LOCAL) {
+      first_global = i;
+      break;
+    }
+  }
+
+  const std::size_t num_sections = object.sections.size();
+  std::size_t num_relas = 0;
+  for (const ObjectSection& section : object.sections) {
+    num_relas += section.relocations.empty() ? 0 : 1;
+  }
+  const std::uint32_t symtab_index = 1 + num_sections + num_relas;
+
+  std::vector<std::vector<Elf64_Rela>> relas;
+  relas.reserve(num_relas);
+  std::string rela_name;
+  for (std::size_t i = 0; i < num_sections; i++) {
+    const ObjectSection& section = object.sections[i];
+    if (section.relocations.empty()) {
+      continue;
+    }
+    std::vector<Elf64_Rela>& rela = relas.emplace_back();
+    for (const ObjectRelocation& relocation : section.relocations) {
+      rela.push_back({relocation.offset,
+                      ELF64_R_INFO(symbol_index[relocation.symbol],
+                                   relocation.type),
+                      relocation.addend});
+    }
+    rela_name = ".rela" + section.name;
+    Elf64_Shdr* header = add_section(
+        rela_name, SHT_RELA, SHF_INFO_LINK, 8,
+        {reinterpret_cast<const char*>(rela.data()),
+         rela.size() * sizeof(Elf64_Rela)});
+    header->sh_link = symtab_index;
+    header->sh_info = i + 1;
+    header->sh_entsize = sizeof(Elf64_Rela);
+  }
+
+  Elf64_Shdr* symtab = add_section(
+      ".symtab", SHT_SYMTAB, 0, 8,
+      {reinterpret_cast<const char*>(symbols.data()),
+       symbols.size() * sizeof(Elf64_Sym)});
+  symtab->sh_link = symtab_index + 1;
+  symtab->sh_info = first_global;
+  symtab->sh_entsize = sizeof(Elf64_Sym);
+  add_section(".strtab", SHT_STRTAB, 0, 1, strings.GetData());
+  // Its own name has to be in it before it's complete.
+  const std::uint32_t shstrtab_name = names.Add(".shstrtab");
+  add_section("", SHT_STRTAB, 0, 1, names.GetData())->sh_name =
+      shstrtab_name;
+
+  Elf64_Ehdr header{};
+  std::memcpy(header.e_ident, ELFMAG, SELFMAG);
+  header.e_ident[EI_CLASS] = ELFCLASS64;
+  header.e_ident[EI_DATA] = ELFDATA2LSB;
+  header.e_ident[EI_VERSION] = EV_CURRENT;
+  header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+  header.e_type = ET_REL;
+  header.e_machine = EM_X86_64;
+  header.e_version = EV_CURRENT;
+  header.e_shoff = (offset + 7) / 8 * 8;
+  header.e_ehsize = sizeof(Elf64_Ehdr);
+  header.e_shentsize = sizeof(Elf64_Shdr);
+  header.e_shnum = headers.size();
+  header.e_shstrndx = headers.size() - 1;
+
+  out.Append(Bytes(header));
+  std::uint64_t written = sizeof(Elf64_Ehdr);
+  auto pad_to = [&](std::uint64_t to) {
+    for (; written < to; written++) {
+      out.Append('\0');
+    }
+  };
+  for (const Piece& piece : pieces) {
+    pad_to(piece.offset);
+    out.Append(piece.data);
+    written += piece.data.size();
+  }
+  pad_to(header.e_shoff);
+  for (const Elf64_Shdr& section : headers) {
+    out.Append(Bytes(section));
+  }
+}
+}  // namespace jcc
@@ -0,0 +1,27 @@
+#include "jcc/identifier_table.h"
+
+#include <cstring>
+
+#include "jcc/keywords.h"
+
+namespace jcc {
+
+IdentifierInfo& IdentifierTable::Get(std::string_view name) {
+  auto iter = table_.find(name);
+  if (iter != table_.end()) {
+    return *iter->second;
+  }
+
+  // The spelling is kept right behind its IdentifierInfo.
+  void* mem = arena_.AllocateAligned(sizeof(IdentifierInfo) + name.size() + 1);
+  char* spelling = static_cast<char*>(mem) + sizeof(IdentifierInfo);
+  std::memcpy(spelling, name.data(), name.size());
+  spelling[name.size()] = '\0';
+
+  std::string_view interned{spelling, name.size()};
+  auto* info = new (mem) IdentifierInfo(
+      interned, Keywords::Match(name).value_or(TokenKind::Identifier));
+  table_.emplace(interned, info);
+  return *info;
+}
+}  // namespace jcc
@@ -0,0 +1,200 @@
+#include "jcc/jit.h"
+
+#include <dlfcn.h>
+#include <elf.h>
+#include <fmt/format.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "jcc/common.h"
+
+namespace jcc {
+
+// A stub is `jmp *slot(%rip)`, padded with int3.
+static constexpr std::size_t stub_size = 8;
+
+static std::uint64_t AlignTo(std::uint64_t n, std::uint64_t align) {
+  return (n + align - 1) / align * align;
+}
+
+static bool IsInt32(std::int64_t value) {
+  return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+JitImage::~JitImage() {
+  if (base_ != nullptr) {
+    munmap(base_, size_);
+  }
+}
+
+std::unique_ptr<JitImage> JitImage::Load(const ObjectFile& object) {
+  const std::size_t num_sections = object.sections.size();
+  const std::size_t num_symbols = object.symbols.size();
+  const auto page_size = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+
+  // Lay it all out, relative to the start of the mapping for now.
+  std::vector<std::uint64_t> section_offsets(num_sections);
+  std::uint64_t size = 0;
+  auto place_sections = [&](bool exec) {
+    for (std::size_t i = 0; i < num_sections; i++) {
+      const ObjectSection& section = object.sections[i];
+      if (!(section.flags & SHF_ALLOC) ||
+          static_cast<bool>(section.flags & SHF_EXECINSTR) != exec) {
+        continue;
+      }
+      size = AlignTo(size, section.alignment);
+      section_offsets[i] = size;
+      size += section.data.size();
+    }
+  };
+
+  // Functions called through the GOT get a slot in it, so do external ones
+  // called directly, which go through a stub loading it.
+  constexpr std::size_t none = SIZE_MAX;
+  std::vector<std::size_t> got_slots(num_symbols, none);
+  std::vector<std::size_t> stubs(num_symbols, none);
+  std::size_t num_got_slots = 0;
+  std::size_t num_stubs = 0;
+  for (const ObjectSection& section : object.sections) {
+    for (const ObjectRelocation& relocation : section.relocations) {
+      const std::size_t symbol = relocation.symbol;
+      const bool external = object.symbols[symbol].section == SHN_UNDEF;
+      const bool needs_stub = relocation.type == R_X86_64_PLT32 && external;
+      if ((relocation.type == R_X86_64_GOTPCREL || needs_stub) &&
+          got_slots[symbol] == none) {
+        got_slots[symbol] = num_got_slots++;
+      }
+      if (needs_stub && stubs[symbol] == none) {
+        stubs[symbol] = num_stubs++;
+      }
+    }
+  }
+
+  place_sections(true);
+  const std::uint64_t stubs_offset = AlignTo(size, 16);
+  size = stubs_offset + num_stubs * stub_size;
+  const std::uint64_t exec_size = AlignTo(size, page_size);
+  const std::uint64_t got_offset = exec_size;
+  size = got_offset + num_got_slots * sizeof(std::uint64_t);
+  place_sections(false);
+  size = AlignTo(std::max<std::uint64_t>(size, 1), page_size);
+
+  void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    fmt::print(stderr, "Can't map memory for the program: {}!\n",
+               std::strerror(errno));
+    return nullptr;
+  }
+  std::unique_ptr<JitImage> image(new JitImage());
+  image->base_ = static_cast<char*>(base);
+  image->size_ = size;
+  const auto base_address = reinterpret_cast<std::uint64_t>(base);
+
+  for (std::size_t i = 0; i < num_sections; i++) {
+    const ObjectSection& section = object.sections[i];
+    if (section.flags & SHF_ALLOC) {
+      std::memcpy(image->base_ + section_offsets[i], section.data.data(),
+                  section.data.size());
+    }
+  }
+
+  std::vector<std::uint64_t> addresses(num_symbols);
+  for (std::size_t i = 0; i < num_symbols; i++) {
+    const ObjectSymbol& symbol = object.symbols[i];
+    if (symbol.section == SHN_UNDEF) {
+      void* address = dlsym(RTLD_DEFAULT, symbol.name.c_str());
+      if (address == nullptr) {
+        fmt::print(stderr, "Undefined symbol: {}!\n", symbol.name);
+        return nullptr;
+      }
+      addresses[i] = reinterpret_cast<std::uint64_t>(address);
+      continue;
+    }
+    addresses[i] = symbol.section == SHN_ABS
+                       ? symbol.value
+                       : base_address + section_offsets[symbol.section - 1] +
+                             symbol.value;
+    if (symbol.binding != STB_LOCAL) {
+      image->symbols_.emplace(symbol.name,
+                              reinterpret_cast<void*>(addresses[i]));
+    }
+  }
+
+  auto got_address = [&](std::size_t symbol) {
+    return base_address + got_offset + got_slots[symbol] * sizeof(addresses[0]);
+  };
+  auto stub_address = [&](std::size_t symbol) {
+    return base_address + stubs_offset + stubs[symbol] * stub_size;
+  };
+  auto write32 = [&](std::uint64_t address, std::int64_t value) {
+    const auto value32 = static_cast<std::int32_t>(value);
+    std::memcpy(reinterpret_cast<void*>(address), &value32, sizeof(value32));
+  };
+  for (std::size_t i = 0; i < num_symbols; i++) {
+    if (got_slots[i] != none) {
+      std::memcpy(reinterpret_cast<void*>(got_address(i)), &addresses[i],
+                  sizeof(addresses[i]));
+    }
+    if (stubs[i] != none) {
+      const std::uint64_t stub = stub_address(i);
+      auto* code = reinterpret_cast<std::uint8_t*>(stub);
+      code[0] = 0xff;
+      code[1] = 0x25;
+      write32(stub + 2, static_cast<std::int64_t>(got_address(i) - (stub + 6)));
+      code[6] = code[7] = 0xcc;
+    }
+  }
+
+  for (std::size_t i = 0; i < num_sections; i++) {
+    const std::uint64_t section_address = base_address + section_offsets[i];
+    for (const ObjectRelocation& relocation : object.sections[i].relocations) {
+      const std::size_t symbol = relocation.symbol;
+      const std::uint64_t place = section_address + relocation.offset;
+      std::uint64_t target;
+      switch (relocation.type) {
+        case R_X86_64_PC32:
+          target = addresses[symbol];
+          break;
+        case R_X86_64_PLT32:
+          target = stubs[symbol] != none ? stub_address(symbol)
+                                         : addresses[symbol];
+          break;
+        case R_X86_64_GOTPCREL:
+          target = got_address(symbol);
+          break;
+        default:
+          jcc_unreachable(
+              fmt::format("Unknown relocation type {}!", relocation.type));
+      }
+      const std::int64_t value =
+          static_cast<std::int64_t>(target - place) + relocation.addend;
+      if (!IsInt32(value)) {
+        fmt::print(stderr, "{} is out of reach of the program!\n",
+                   object.symbols[symbol].name);
+        return nullptr;
+      }
+      write32(place, value);
+    }
+  }
+
+  // Done writing the code, it's executable from now on instead.
+  if (exec_size != 0 && mprotect(base, exec_size, PROT_READ | PROT_EXEC) < 0) {
+    fmt::print(stderr, "Can't make the program executable: {}!\n",
+               std::strerror(errno));
+    return nullptr;
+  }
+  return image;
+}
+
+void* JitImage::GetSymbol(std::string_view name) const {
+  auto iter = symbols_.find(std::string(name));
+  return iter == symbols_.end() ? nullptr : iter->second;
+}
+}  // namespace jcc
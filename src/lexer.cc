@@ -2,62 +2,6 @@
 
 namespace jcc {
 
-Keywords::Keywords() {
-  // TODO(Jun): Use macros to reduce the work?
-  keywords_.insert({"do", TokenKind::Do});
-  keywords_.insert({"alignof", TokenKind::AlignOf});
-  keywords_.insert({"auto", TokenKind::Auto});
-  keywords_.insert({"break", TokenKind::Break});
-  keywords_.insert({"case", TokenKind::Case});
-  keywords_.insert({"char", TokenKind::Char});
-  keywords_.insert({"const", TokenKind::Const});
-  keywords_.insert({"continue", TokenKind::Continue});
-  keywords_.insert({"default", TokenKind::Default});
-  keywords_.insert({"do", TokenKind::Do});
-  keywords_.insert({"double", TokenKind::Double});
-  keywords_.insert({"else", TokenKind::Else});
-  keywords_.insert({"enum", TokenKind::Enum});
-  keywords_.insert({"extern", TokenKind::Extern});
-  keywords_.insert({"float", TokenKind::Float});
-  keywords_.insert({"for", TokenKind::For});
-  keywords_.insert({"goto", TokenKind::Goto});
-  keywords_.insert({"if", TokenKind::If});
-  keywords_.insert({"inline", TokenKind::Inline});
-  keywords_.insert({"int", TokenKind::Int});
-  keywords_.insert({"long", TokenKind::Long});
-  keywords_.insert({"register", TokenKind::Register});
-  keywords_.insert({"restrict", TokenKind::Restrict});
-  keywords_.insert({"return", TokenKind::Return});
-  keywords_.insert({"short", TokenKind::Short});
-  keywords_.insert({"signed", TokenKind::Signed});
-  keywords_.insert({"sizeof", TokenKind::Sizeof});
-  keywords_.insert({"static", TokenKind::Static});
-  keywords_.insert({"struct", TokenKind::Struct});
-  keywords_.insert({"switch", TokenKind::Switch});
-  keywords_.insert({"typedef", TokenKind::Typedef});
-  keywords_.insert({"union", TokenKind::Union});
-  keywords_.insert({"unsigned", TokenKind::Unsigned});
-  keywords_.insert({"void", TokenKind::Void});
-  keywords_.insert({"while", TokenKind::While});
-  keywords_.insert({"_Alignas", TokenKind::DashAlignas});
-  keywords_.insert({"_Atomic", TokenKind::DashAtmoic});
-  keywords_.insert({"_Bool", TokenKind::DashBool});
-  keywords_.insert({"_Complex", TokenKind::DashComplex});
-  keywords_.insert({"_Generic", TokenKind::DashGeneric});
-  keywords_.insert({"_Imaginary", TokenKind::DashImaginary});
-  keywords_.insert({"_Noreturn", TokenKind::DashNoReturn});
-  keywords_.insert({"_Static_assert", TokenKind::DashStaticAssert});
-  keywords_.insert({"_Thread_local", TokenKind::DashThreadLocal});
-}
-
-std::optional<TokenKind> Keywords::matchKeyword(std::string_view identifier) {
-  auto search = keywords_.find(identifier);
-  if (search != keywords_.end()) {
-    return search->second;
-  }
-  return std::nullopt;
-}
-
 Token Lexer::Lex() {
   SkipWhitespace();
   switch (Peek()) {
@@ -141,7 +85,7 @@ Token Lexer::Lex() {
     case '.':
       return LexAtom(TokenKind::Period);
     case '-': {
-      SourceLocation loc{line_, column_, GetOffset()};
+      SourceLocation loc = GetLocation();
       if (TryConsume('>')) {
         return LexAtom(TokenKind::Arrow, loc);
       }
@@ -154,7 +98,7 @@ Token Lexer::Lex() {
       return LexAtom(TokenKind::Minus, loc);
     }
     case '+': {
-      SourceLocation loc{line_, column_, GetOffset()};
+      SourceLocation loc = GetLocation();
       if (TryConsume('+')) {
         return LexAtom(TokenKind::PlusPlus, loc);
       }
@@ -164,7 +108,7 @@ Token Lexer::Lex() {
       return LexAtom(TokenKind::Plus, loc);
     }
     case '&': {
-      SourceLocation loc{line_, column_, GetOffset()};
+      SourceLocation loc = GetLocation();
 
       if (TryConsume('&')) {
         return LexAtom(TokenKind::AmpersandAmpersand, loc);
@@ -172,7 +116,7 @@ Token Lexer::Lex() {
       return LexAtom(TokenKind::Ampersand, loc);
     }
     case '*': {
-      SourceLocation loc{line_, column_, GetOffset()};
+      SourceLocation loc = GetLocation();
       if (TryConsume('=')) {
         return LexAtom(TokenKind::StarEqual, loc);
       }
@@ -181,35 +125,32 @@ Token Lexer::Lex() {
     case '~':
       return LexAtom(TokenKind::Tilde);
     case '!': {
-      SourceLocation loc{line_, column_, GetOffset()};
+      SourceLocation loc = GetLocation();
       if (TryConsume('=')) {
         return LexAtom(TokenKind::NotEqual, loc);
       }
       return LexAtom(TokenKind::Question, loc);
     }
     case '/': {
-      SourceLocation loc{line_, column_, GetOffset()};
-      if (TryConsume('*')) {
-        // skip comments
-        while (true) {
-          SkipUntil('*', /*skip_match=*/true);
-          TryConsume('/');
-        }
+      if (PeekAhead() == '*') {
+        SkipBlockComment();
+        return Lex();
       }
+      SourceLocation loc = GetLocation();
       if (TryConsume('=')) {
         return LexAtom(TokenKind::SlashEqual, loc);
       }
       return LexAtom(TokenKind::Slash, loc);
     }
     case '%': {
-      SourceLocation loc{line_, column_, GetOffset()};
+      SourceLocation loc = GetLocation();
       if (TryConsume('=')) {
         return LexAtom(TokenKind::PercentEqual, loc);
       }
       return LexAtom(TokenKind::Percent, loc);
     }
     case '<': {
-      SourceLocation loc{line_, column_, GetOffset()};
+      SourceLocation loc = GetLocation();
       if (TryConsume('<')) {
         if (TryConsume('=')) {
           return LexAtom(TokenKind::LeftShiftEqual, loc);
@@ -217,12 +158,12 @@ Token Lexer::Lex() {
         return LexAtom(TokenKind::LeftShift, loc);
       }
       if (TryConsume('=')) {
-        return LexAtom(TokenKind::LessEqual);
+        return LexAtom(TokenKind::LessEqual, loc);
       }
-      return LexAtom(TokenKind::Less);
+      return LexAtom(TokenKind::Less, loc);
     }
     case '>': {
-      SourceLocation loc{line_, column_, GetOffset()};
+      SourceLocation loc = GetLocation();
       if (TryConsume('>')) {
         if (TryConsume('=')) {
           return LexAtom(TokenKind::RightShiftEqual, loc);
@@ -235,21 +176,21 @@ Token Lexer::Lex() {
       return LexAtom(TokenKind::Greater, loc);
     }
     case '=': {
-      SourceLocation loc{line_, column_, GetOffset()};
+      SourceLocation loc = GetLocation();
       if (TryConsume('=')) {
-        return LexAtom(TokenKind::EqualEqual);
+        return LexAtom(TokenKind::EqualEqual, loc);
       }
-      return LexAtom(TokenKind::Equal);
+      return LexAtom(TokenKind::Equal, loc);
     }
     case '^': {
-      SourceLocation loc{line_, column_, GetOffset()};
+      SourceLocation loc = GetLocation();
       if (TryConsume('=')) {
         return LexAtom(TokenKind::CarretEqual, loc);
       }
       return LexAtom(TokenKind::Carret, loc);
     }
     case '|': {
-      SourceLocation loc{line_, column_, GetOffset()};
+      SourceLocation loc = GetLocation();
       if (TryConsume('=')) {
         return LexAtom(TokenKind::PipeEqual, loc);
       }
@@ -284,58 +225,57 @@ Token Lexer::Lex() {
   }
 }
 
-void Lexer::SkipWhitespace() {
-  while (std::isspace(Peek()) != 0) {
-    Advance();
+TokenBuffer Lexer::LexAll() {
+  TokenBuffer tokens(buffer_start_, file_loc_);
+  // Real code averages well over 4 bytes per token, so this rarely grows.
+  tokens.Reserve((buffer_end_ - buffer_ptr_) / 4 + 1);
+  while (true) {
+    Token token = Lex();
+    tokens.Push(token);
+    if (token.Is<TokenKind::Eof>()) {
+      return tokens;
+    }
   }
 }
 
-bool Lexer::IsValidChar() const {
-  bool flag = false;
-  char cha = Peek();
-  if (cha >= 'A' && cha <= 'Z') {
-    flag = true;
+void Lexer::LexAll(TokenQueue& queue) {
+  while (true) {
+    Token token = Lex();
+    queue.Push(token);
+    if (token.Is<TokenKind::Eof>()) {
+      return;
+    }
   }
+}
 
-  if (cha >= 'a' && cha <= 'z') {
-    flag = true;
-  }
+void Lexer::SkipWhitespace() {
+  buffer_ptr_ = scanner_.SkipWhitespace(buffer_ptr_);
+}
 
-  if (cha == '_') {
-    flag = true;
+void Lexer::SkipBlockComment() {
+  const char* end = scanner_.FindCommentEnd(buffer_ptr_ + 2);
+  if (*end == '\0') {
+    jcc_unreachable("Unterminated block comment!");
   }
-
-  return flag;
+  buffer_ptr_ = end + 2;  // Eat the end '*/'
 }
 
-bool Lexer::IsLineTerminator() const { return *buffer_ptr_ == '\n'; }
-
 void Lexer::Advance() {
   assert(buffer_ptr_ != buffer_end_ + 1 && "Have already reached EOF!");
   buffer_ptr_++;
-  // FIXME: This won't work with windows files.
-  if (IsLineTerminator()) {
-    line_ = 1;
-    column_++;
-    buffer_ptr_++;
-  } else {
-    line_++;
-  }
 }
 
-char Lexer::Peek() const {
-  if (buffer_ptr_ == buffer_end_) {
-    return '\0';
-  }
-  return *buffer_ptr_;
-}
+// The buffer is NUL terminated, so there's no need to check for its end.
+char Lexer::Peek() const { return *buffer_ptr_; }
 
 char Lexer::PeekAhead(int offset) const {
   assert(buffer_ptr_ + offset != buffer_end_ && "Cannot peek over the buffer!");
   return *(buffer_ptr_ + offset);
 }
 
-std::size_t Lexer::GetOffset() const { return buffer_end_ - buffer_ptr_; }
+SourceLocation Lexer::GetLocation() const {
+  return file_loc_.GetLocWithOffset(buffer_ptr_ - buffer_start_);
+}
 
 bool Lexer::TryConsume(char cha) {
   if (PeekAhead() == cha) {
@@ -345,56 +285,38 @@ bool Lexer::TryConsume(char cha) {
   return false;
 }
 
-void Lexer::SkipUntil(char cha, bool skip_match) {
-  while (Peek() != cha) {
-    Advance();
-  }
-  if (skip_match) {
-    Advance();
-  }
-}
-
 bool Lexer::HasDone() const { return buffer_ptr_ == buffer_end_ + 1; }
 
 Token Lexer::LexAtom(TokenKind kind) {
-  Token tok{kind, buffer_ptr_, 1, SourceLocation{line_, column_, GetOffset()}};
+  Token tok{kind, buffer_ptr_, 1, GetLocation()};
   Advance();
   return tok;
 }
 
+// The token spans from `loc` through the current character, so its spelling
+// and location agree for punctuators of more than one character.
 Token Lexer::LexAtom(TokenKind kind, SourceLocation loc) {
-  Token tok{kind, buffer_ptr_, 1, loc};
+  const char* data = buffer_start_ + (loc.GetOffset() - file_loc_.GetOffset());
   Advance();
-  return tok;
+  return {kind, data, static_cast<Token::TokenSize>(buffer_ptr_ - data), loc};
 }
 
 // FIXME: can identifiers contain numbers?
 Token Lexer::LexIdentifierOrKeyword() {
-  SourceLocation loc{line_, column_, GetOffset()};
+  SourceLocation loc = GetLocation();
   const char* data = buffer_ptr_;
-  Token::TokenSize len = 1;
-  Advance();
-
-  while (true) {
-    Peek();
-    if (!IsValidChar()) {
-      break;
-    }
-    len++;
-    Advance();
-  }
-  // the token may be a keyword.
-  std::string_view tok{data, len};
-  if (auto keyword = keywords_.matchKeyword({data, len})) {
-    return {*keyword, data, len, loc};
-  }
+  const char* end = scanner_.SkipIdentifier(buffer_ptr_ + 1);
+  Token::TokenSize len = end - data;
+  buffer_ptr_ = end;
 
-  return {TokenKind::Identifier, data, len, loc};
+  // The token may be a keyword, the IdentifierInfo knows.
+  IdentifierInfo& ident = idents_.Get({data, len});
+  return {ident.GetTokenKind(), data, len, loc, &ident};
 }
 
 Token Lexer::LexStringLiteral() {
   Advance();  // Eat the begin '"'
-  SourceLocation loc{line_, column_, GetOffset()};
+  SourceLocation loc = GetLocation();
   const char* data = buffer_ptr_;
   Token::TokenSize len = 0;
 
@@ -403,6 +325,12 @@ Token Lexer::LexStringLiteral() {
       Advance();  // Eat the end '"'
       break;
     }
+    // Keep escape sequences as they are, but don't let an escaped '"' end
+    // the literal.
+    if (Peek() == '\\') {
+      len++;
+      Advance();
+    }
     len++;
     Advance();
   }
@@ -411,28 +339,28 @@ Token Lexer::LexStringLiteral() {
 }
 Token Lexer::LexCharacterLiteral() {
   Advance();  // Eat the begin " ' "
-  SourceLocation loc{line_, column_, GetOffset()};
+  SourceLocation loc = GetLocation();
   const char* data = buffer_ptr_;
-  Advance();  // Eat the character
+  Token::TokenSize len = 0;
+  while (Peek() != '\'') {
+    if (Peek() == '\\') {
+      len++;
+      Advance();
+    }
+    len++;
+    Advance();
+  }
   Advance();  // Eat the end " ' "
-  return Token{TokenKind::Char, data, 1, loc};
+  return Token{TokenKind::Char, data, len, loc};
 }
 
 // TODO(Jun): extend this to support hex and exp
 Token Lexer::LexNumericConstant() {
   const char* data = buffer_ptr_;
-  Token::TokenSize len = 1;
-  SourceLocation loc{line_, column_, GetOffset()};
-  Advance();
-  while (true) {
-    char cha = Peek();
-    if (std::isdigit(cha) != 0 || cha == '.') {
-      len++;
-      Advance();
-    } else {
-      break;
-    }
-  }
+  SourceLocation loc = GetLocation();
+  const char* end = scanner_.SkipDigits(buffer_ptr_ + 1);
+  Token::TokenSize len = end - data;
+  buffer_ptr_ = end;
   return Token{TokenKind::NumericConstant, data, len, loc};
 }
 }  // namespace jcc
@@ -0,0 +1,32 @@
+#include "jcc/line_table.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace jcc {
+
+LineTable::LineTable(std::string_view buffer) {
+  line_starts_.push_back(0);
+  // memchr is vectorized by every libc we care about, which makes it far
+  // cheaper than looking at the buffer one byte at a time.
+  const char* begin = buffer.data();
+  const char* end = begin + buffer.size();
+  for (const char* cur = begin;
+       (cur = static_cast<const char*>(std::memchr(cur, '\n', end - cur))) !=
+       nullptr;) {
+    cur++;
+    line_starts_.push_back(static_cast<std::uint32_t>(cur - begin));
+  }
+}
+
+std::size_t LineTable::GetLineNumber(std::uint32_t offset) const {
+  // The first line starting after `offset`, the one before it contains it.
+  auto next =
+      std::upper_bound(line_starts_.begin(), line_starts_.end(), offset);
+  return next - line_starts_.begin();
+}
+
+std::size_t LineTable::GetColumnNumber(std::uint32_t offset) const {
+  return offset - line_starts_[GetLineNumber(offset) - 1] + 1;
+}
+}  // namespace jcc
@@ -2,5 +2,5 @@
 
 int main(int argc, char** argv) {
   jcc::Driver driver(argc, argv);
-  driver.Run();
+  return driver.Run();
 }
@@ -0,0 +1,106 @@
+#include "jcc/memory_buffer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+namespace jcc {
+
+// Below this, setting up and tearing down a mapping costs more than copying.
+static constexpr std::size_t min_mapped_size = 16 * 1024;
+
+MemoryBuffer::~MemoryBuffer() {
+  if (IsMapped()) {
+    munmap(const_cast<char*>(data_), mapped_size_);
+  } else {
+    delete[] data_;
+  }
+}
+
+std::unique_ptr<MemoryBuffer> MemoryBuffer::GetFile(std::string_view path) {
+  int fd = open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat status {};
+  std::unique_ptr<MemoryBuffer> buffer;
+  if (fstat(fd, &status) == 0) {
+    auto size = static_cast<std::size_t>(status.st_size);
+    if (S_ISREG(status.st_mode) && size >= min_mapped_size) {
+      buffer = Map(fd, size);
+    }
+    // Falls back to reading if the mapping failed.
+    if (buffer == nullptr) {
+      buffer = Read(fd, S_ISREG(status.st_mode) ? size : 0);
+    }
+  }
+  close(fd);
+  return buffer;
+}
+
+std::unique_ptr<MemoryBuffer> MemoryBuffer::GetSTDIN() {
+  return Read(STDIN_FILENO, 0);
+}
+
+std::unique_ptr<MemoryBuffer> MemoryBuffer::Read(int fd,
+                                                 std::size_t size_hint) {
+  std::size_t capacity = size_hint != 0 ? size_hint + 1 : 4096;
+  std::unique_ptr<char[]> data(new char[capacity]);
+  std::size_t size = 0;
+  // A regular file is read in one go, no need to grow the buffer only to
+  // find its end.
+  while (size_hint == 0 || size < size_hint) {
+    if (size + 1 == capacity) {
+      auto grown = std::make_unique<char[]>(capacity * 2);
+      std::memcpy(grown.get(), data.get(), size);
+      data = std::move(grown);
+      capacity *= 2;
+    }
+    ssize_t count = read(fd, data.get() + size, capacity - size - 1);
+    if (count == 0) {
+      break;
+    }
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return nullptr;
+    }
+    size += count;
+  }
+  data[size] = '\0';
+
+  std::unique_ptr<MemoryBuffer> buffer(new MemoryBuffer());
+  buffer->data_ = data.release();
+  buffer->size_ = size;
+  return buffer;
+}
+
+std::unique_ptr<MemoryBuffer> MemoryBuffer::Map(int fd, std::size_t size) {
+  const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  // The bytes past the end of the file in its last page read as zero, unless
+  // there are none, then we need a whole zero page for the sentinel.
+  std::size_t mapped_size = (size + page_size) & ~(page_size - 1);
+  void* mem = mmap(nullptr, mapped_size, PROT_READ,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED) {
+    return nullptr;
+  }
+  if (mmap(mem, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) ==
+      MAP_FAILED) {
+    munmap(mem, mapped_size);
+    return nullptr;
+  }
+
+  std::unique_ptr<MemoryBuffer> buffer(new MemoryBuffer());
+  buffer->data_ = static_cast<const char*>(mem);
+  buffer->size_ = size;
+  buffer->mapped_size_ = mapped_size;
+  return buffer;
+}
+}  // namespace jcc
@@ -1,11 +1,16 @@
 #include "jcc/parser.h"
 
 #include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <string_view>
 
+#include "jcc/casting.h"
 #include "jcc/common.h"
 #include "jcc/decl.h"
 #include "jcc/declarator.h"
 #include "jcc/expr.h"
+#include "jcc/identifier_table.h"
 #include "jcc/lexer.h"
 #include "jcc/source_location.h"
 #include "jcc/stmt.h"
@@ -64,18 +69,55 @@ static BinOpPreLevel GetBinOpPrecedence(TokenKind kind) {
   }
 }
 
-Parser::Parser(Lexer& lexer) : lexer_(lexer) { token_ = lexer_.Lex(); }
+Parser::Parser(Lexer& lexer)
+    : lexer_(lexer), ctx_(lexer.GetIdentifierTable()) {
+  FillTokens(1);
+}
+
+Parser::Parser(Lexer& lexer, const TokenBuffer& tokens)
+    : lexer_(lexer), token_buffer_(&tokens), ctx_(lexer.GetIdentifierTable()) {
+  FillTokens(1);
+}
 
-Token Parser::CurrentToken() { return token_; }
+Parser::Parser(Lexer& lexer, TokenQueue& tokens)
+    : lexer_(lexer), token_queue_(&tokens), ctx_(lexer.GetIdentifierTable()) {
+  FillTokens(1);
+}
+
+void Parser::FillTokens(std::size_t count) {
+  while (num_tokens_ < lookahead_capacity && !reached_eof_) {
+    Token& slot = tokens_[(head_ + num_tokens_) & (lookahead_capacity - 1)];
+    if (token_buffer_ != nullptr) {
+      slot = token_buffer_->GetToken(next_token_++);
+    } else if (token_queue_ != nullptr) {
+      // Take whatever the lexer thread has published so far, but only wait
+      // for it when we don't have the tokens we were asked for yet.
+      if (!token_queue_->TryPop(slot)) {
+        if (num_tokens_ >= count) {
+          return;
+        }
+        slot = token_queue_->Pop();
+      }
+    } else {
+      slot = lexer_.Lex();
+    }
+    reached_eof_ = slot.Is<TokenKind::Eof>();
+    num_tokens_++;
+  }
+}
+
+Token Parser::CurrentToken() { return tokens_[head_]; }
 
 Token Parser::ConsumeToken() {
-  if (cache_) {
-    token_ = *cache_;
-    cache_ = std::nullopt;
-  } else {
-    token_ = lexer_.Lex();
+  // Eof is never consumed, the parser keeps seeing it.
+  if (num_tokens_ == 1 && reached_eof_) {
+    return tokens_[head_];
+  }
+  head_ = (head_ + 1) & (lookahead_capacity - 1);
+  if (--num_tokens_ == 0) {
+    FillTokens(1);
   }
-  return token_;
+  return tokens_[head_];
 }
 
 void Parser::MustConsumeToken(TokenKind expected) {
@@ -86,10 +128,14 @@ void Parser::MustConsumeToken(TokenKind expected) {
   jcc_unreachable("MustConsumeToken() consumed unexpeted token!");
 }
 
-Token Parser::NextToken() {
-  Token next_tok = lexer_.Lex();
-  cache_ = next_tok;
-  return next_tok;
+Token Parser::PeekToken(std::size_t n) {
+  assert(n < lookahead_capacity && "Can't look that far ahead!");
+  if (n >= num_tokens_) {
+    FillTokens(n + 1);
+    // Everything after Eof is Eof.
+    n = std::min(n, num_tokens_ - 1);
+  }
+  return tokens_[(head_ + n) & (lookahead_capacity - 1)];
 }
 
 bool Parser::TryConsumeToken(TokenKind expected) {
@@ -109,8 +155,7 @@ void Parser::SkipUntil(TokenKind kind, bool skip_match) {
   }
 }
 
-std::vector<Type*> Parser::ParseMembers() {
-  std::vector<Type*> members;
+void Parser::ParseMembers(SmallVectorImpl<Type*>& members) {
   while (true) {
     DeclSpec decl_spec = ParseDeclSpec();
     Declarator declarator = ParseDeclarator(decl_spec);
@@ -121,7 +166,6 @@ std::vector<Type*> Parser::ParseMembers() {
       break;
     }
   }
-  return members;
 }
 
 Type* Parser::ParseRecordType(TokenKind kind) {
@@ -136,12 +180,15 @@ Type* Parser::ParseRecordType(TokenKind kind) {
 
   Type* type = Type::CreateRecordType(GetASTContext(), type_kind);
   if (CurrentToken().Is<TokenKind::Identifier>()) {
-    type->SetName(CurrentToken());
+    type->SetName(CurrentToken().GetIdentifierInfo());
     ConsumeToken();
   }
 
   if (TryConsumeToken(TokenKind::LeftBracket)) {
-    type->AsType<RecordType>()->SetMembers(ParseMembers());
+    SmallVector<Type*, 8> members;
+    ParseMembers(members);
+    type->AsType<RecordType>()->SetMembers(
+        GetASTContext().CopyArray<Type*>(members));
   }
 
   return type;
@@ -264,7 +311,7 @@ DeclSpec Parser::ParseDeclSpec() {
       case Identifier: {
         // When running into an identifier, presumably it's type alias or user
         // defined type. Thus look up it in the scope, and set it for DeclSpec.
-        decl_spec.SetType(LookupType(CurrentToken().GetAsString()));
+        decl_spec.SetType(LookupType(CurrentToken().GetIdentifierInfo()));
         break;
       }
       default:
@@ -282,7 +329,7 @@ Type* Parser::ParsePointers(Declarator& declarator) {
   using enum TokenKind;
   Type* type = declarator.GetType();
   while (TryConsumeToken(Star)) {
-    type = Type::CreatePointerType(GetASTContext(), type);
+    type = GetASTContext().GetPointerType(type);
     while (CurrentToken().IsOneOf<Const, Volatile, Restrict>()) {
       ConsumeToken();
     }
@@ -290,12 +337,12 @@ Type* Parser::ParsePointers(Declarator& declarator) {
   return type;
 }
 
-Type* Parser::ParseTypeSuffix(Type* type) {
+Type* Parser::ParseTypeSuffix(Type* type, Declarator& declarator) {
   if (TryConsumeToken(TokenKind::LeftParen)) {
-    return ParseParams(type);
+    return ParseParams(type, declarator);
   }
   if (TryConsumeToken(TokenKind::LeftSquare)) {
-    return ParseArrayDimensions(type);
+    return ParseArrayDimensions(type, declarator);
   }
   return type;
 }
@@ -307,7 +354,7 @@ Declarator Parser::ParseDeclarator(DeclSpec& decl_spec) {
     DeclSpec dummy(GetASTContext());
     ParseDeclarator(dummy);
     ConsumeToken();  // Eat ')'
-    Type* suffix_type = ParseTypeSuffix(type);
+    Type* suffix_type = ParseTypeSuffix(type, declarator);
     DeclSpec suffix(GetASTContext());
     suffix.SetType(suffix_type);
     return ParseDeclarator(suffix);
@@ -320,7 +367,7 @@ Declarator Parser::ParseDeclarator(DeclSpec& decl_spec) {
     name = CurrentToken();
     ConsumeToken();
     // Keep the token and set it later, or it will be flushed away.
-    declarator.SetType(ParseTypeSuffix(type));
+    declarator.SetType(ParseTypeSuffix(type, declarator));
     declarator.SetName(name);
   }
   return declarator;
@@ -334,44 +381,42 @@ Declarator Parser::ParseAbstractDeclarator(DeclSpec& decl_spec) {
     DeclSpec dummy(GetASTContext());
     ParseDeclarator(dummy);
     ConsumeToken();  // Eat ')'
-    Type* suffix_type = ParseTypeSuffix(type);
+    Type* suffix_type = ParseTypeSuffix(type, declarator);
     DeclSpec suffix(GetASTContext());
     suffix.SetType(suffix_type);
     return ParseDeclarator(suffix);
   }
 
-  declarator.SetType(ParseTypeSuffix(type));
+  declarator.SetType(ParseTypeSuffix(type, declarator));
   return declarator;
 }
 
-Type* Parser::ParseParams(Type* type) {
-  Type* function_type = Type::CreateFuncType(GetASTContext(), type);
+Type* Parser::ParseParams(Type* type, Declarator& declarator) {
   // 1. int foo(void)
   // 2. int foo()
   if ((CurrentToken().Is<TokenKind::Void>() &&
-       NextToken().Is<TokenKind::RightParen>()) ||
+       PeekToken(1).Is<TokenKind::RightParen>()) ||
       CurrentToken().Is<TokenKind::RightParen>()) {
     SkipUntil(TokenKind::RightParen, /*skip_match=*/true);
-    return function_type;
+    return GetASTContext().GetFunctionType(type, {});
   }
 
-  std::vector<Type*> params;
+  SmallVector<Type*, 8> params;
+  std::vector<IdentifierInfo*> names;
   while (true) {
     DeclSpec decl_spec = ParseDeclSpec();
-    Declarator declarator = ParseDeclarator(decl_spec);
+    Declarator param = ParseDeclarator(decl_spec);
     Type* param_type = decl_spec.GetType();
 
-    if (declarator.GetTypeKind() == TypeKind::Array) {
-      param_type = Type::CreatePointerType(
-          GetASTContext(),
-          declarator.GetType()->AsType<PointerType>()->GetBase());
-      // FIXME: set name to type.
-    } else if (declarator.GetTypeKind() == TypeKind::Func) {
-      param_type =
-          Type::CreatePointerType(GetASTContext(), declarator.GetType());
+    if (param.GetTypeKind() == TypeKind::Array) {
+      param_type = GetASTContext().GetPointerType(
+          param.GetType()->AsType<ArrayType>()->GetBase());
+    } else if (param.GetTypeKind() == TypeKind::Func) {
+      param_type = GetASTContext().GetPointerType(param.GetType());
     }
 
     params.push_back(param_type);
+    names.push_back(param.GetName());
 
     if (TryConsumeToken(TokenKind::RightParen)) {
       break;
@@ -380,19 +425,19 @@ Type* Parser::ParseParams(Type* type) {
     MustConsumeToken(TokenKind::Comma);
   }
 
-  function_type->AsType<FunctionType>()->SetParams(std::move(params));
-  return function_type;
+  declarator.SetParamNames(std::move(names));
+  return GetASTContext().GetFunctionType(type, params);
 }
 
-Type* Parser::ParseArrayDimensions(Type* type) {
+Type* Parser::ParseArrayDimensions(Type* type, Declarator& declarator) {
   while (CurrentToken().IsOneOf<TokenKind::Static, TokenKind::Restrict>()) {
     ConsumeToken();
   }
 
   if (TryConsumeToken(TokenKind::RightParen)) {
-    Type* arr_type = ParseTypeSuffix(type);
+    Type* arr_type = ParseTypeSuffix(type, declarator);
     // FIXME: What is the length BTW?
-    return Type::CreateArrayType(GetASTContext(), arr_type, 0);
+    return GetASTContext().GetArrayType(arr_type, 0);
   }
 
   // cond ? A : B
@@ -458,15 +503,15 @@ Stmt* Parser::ParseSwitchStmt() {
   Expr* condition = ParseExpr();
   MustConsumeToken(TokenKind::RightParen);
   MustConsumeToken(TokenKind::LeftBracket);
-  auto* body = ParseCompoundStmt()->As<CompoundStatement>();
+  auto* body = cast<CompoundStatement>(ParseCompoundStmt());
   return SwitchStatement::Create(GetASTContext(), SourceRange(), condition,
                                  body);
 }
 
 Stmt* Parser::ParseCaseStmt(bool is_default) {
-  std::optional<std::string> value = std::nullopt;
+  std::string_view value;
   if (!is_default) {
-    value = CurrentToken().GetAsString();
+    value = CurrentToken().GetStrView();
     ConsumeToken();
   }
   MustConsumeToken(TokenKind::Colon);
@@ -562,26 +607,23 @@ Stmt* Parser::ParseStatement() {
   return ParseExprStmt();
 }
 
-std::vector<VarDecl*> Parser::CreateParams(FunctionType* type) {
-  std::vector<VarDecl*> params;
+std::span<VarDecl*> Parser::CreateParams(
+    FunctionType* type, const std::vector<IdentifierInfo*>& names) {
+  SmallVector<VarDecl*, 8> params;
   for (std::size_t idx = 0; idx < type->GetParamSize(); idx++) {
-    Type* param_type = type->GetParamType(idx);
-    // TODO(Jun): This doesn't work with parameters with names.
     params.push_back(VarDecl::Create(GetASTContext(), SourceRange(), nullptr,
-                                     param_type,
-                                     param_type->GetNameAsString()));
+                                     type->GetParamType(idx), names[idx]));
   }
-  return params;
+  return GetASTContext().CopyArray<VarDecl*>(params);
 }
 
 Stmt* Parser::ParseCompoundStmt() {
-  CompoundStatement* stmt =
-      CompoundStatement::Create(GetASTContext(), SourceRange());
+  SmallVector<Stmt*, 16> stmts;
   ScopeRAII scope_guard(*this);  // FIXME: Create another scope, but it could be
                                  // a function body, so we create it twice?
 
   while (!CurrentToken().Is<TokenKind::RightBracket>()) {
-    if (IsType(CurrentToken()) && !NextToken().Is<TokenKind::Colon>()) {
+    if (IsType(CurrentToken()) && !PeekToken(1).Is<TokenKind::Colon>()) {
       DeclSpec decl_spec = ParseDeclSpec();
       if (decl_spec.IsTypedef()) {
         // Parse Typedef
@@ -590,21 +632,22 @@ Stmt* Parser::ParseCompoundStmt() {
       }
       Declarator declarator = ParseDeclarator(decl_spec);
       if (declarator.GetTypeKind() == TypeKind::Func) {
-        stmt->AddStmt(DeclStatement::Create(GetASTContext(), SourceRange(),
-                                            ParseFunction(declarator)));
+        stmts.push_back(DeclStatement::Create(GetASTContext(), SourceRange(),
+                                              ParseFunction(declarator)));
         continue;
       }
-      std::vector<Decl*> decls = ParseDeclaration(declarator);
-      stmt->AddStmt(
+      SmallVector<Decl*, 4> decls;
+      ParseDeclaration(declarator, decls);
+      stmts.push_back(
           DeclStatement::Create(GetASTContext(), SourceRange(), decls));
-      GetASTContext().GetCurFunc()->AddLocals(decls);
+      locals_.insert(locals_.end(), decls.begin(), decls.end());
     } else {
-      stmt->AddStmt(ParseStatement());
+      stmts.push_back(ParseStatement());
     }
     // Add type?
   }
   ConsumeToken();  // Eat '}'
-  return stmt;
+  return CompoundStatement::Create(GetASTContext(), SourceRange(), stmts);
 }
 
 [[nodiscard]] bool Parser::IsType(Token token) const {
@@ -639,15 +682,20 @@ Stmt* Parser::ParseCompoundStmt() {
     case TokenKind::DashNoReturn:
     case TokenKind::DashThreadLocal:
       return true;
+    case TokenKind::Identifier: {
+      // Only look into the scopes if the identifier has ever named a type.
+      IdentifierInfo* ident = token.GetIdentifierInfo();
+      return ident->MaybeTypeName() && LookupType(ident) != nullptr;
+    }
     default:
       break;
   }
-  return LookupType(token.GetAsString()) != nullptr;
+  return false;
 }
 
 Decl* Parser::ParseFunction(Declarator& declarator) {
-  std::string func_name = declarator.GetName();
-  if (func_name.empty()) {
+  IdentifierInfo* func_name = declarator.GetName();
+  if (func_name == nullptr) {
     jcc_unreachable("function name is missing!");
   }
   // Check redefinition
@@ -661,11 +709,11 @@ Decl* Parser::ParseFunction(Declarator& declarator) {
   FunctionDecl* function =
       FunctionDecl::Create(GetASTContext(), SourceRange(), func_name, func_type,
                            func_type->GetReturnType());
-  GetASTContext().SetCurFunc(function);
+  const std::size_t first_local = locals_.size();
 
   ScopeRAII scope_guard(*this);
 
-  function->SetParams(CreateParams(func_type));
+  function->SetParams(CreateParams(func_type, declarator.GetParamNames()));
 
   if (TryConsumeToken(TokenKind::LeftBracket)) {
     function->SetBody(ParseCompoundStmt());
@@ -675,6 +723,9 @@ Decl* Parser::ParseFunction(Declarator& declarator) {
     jcc_unreachable("error when parsing function body!");
   }
 
+  function->SetLocals(GetASTContext().CopyArray<Decl*>(
+      std::span(locals_).subspan(first_local)));
+  locals_.resize(first_local);
   return function;
 }
 
@@ -682,20 +733,20 @@ Decl* Parser::ParseFunction(Declarator& declarator) {
 // 2. int x = 0;
 // 3. int x, y;
 // 4. int x, y, z = 0;
-std::vector<Decl*> Parser::ParseDeclaration(Declarator& declarator) {
-  std::vector<Decl*> vars;
-
-  vars.push_back(VarDecl::Create(GetASTContext(), SourceRange(), nullptr,
-                                 declarator.GetType(), declarator.GetName()));
+void Parser::ParseDeclaration(Declarator& declarator,
+                              SmallVectorImpl<Decl*>& decls) {
+  const std::size_t first = decls.size();
+  decls.push_back(VarDecl::Create(GetASTContext(), SourceRange(), nullptr,
+                                  declarator.GetType(), declarator.GetName()));
   // Parse optional decls.
   while (!CurrentToken().Is<TokenKind::Semi>() &&
          !CurrentToken().Is<TokenKind::Equal>()) {
     MustConsumeToken(TokenKind::Comma);
 
     if (CurrentToken().Is<TokenKind::Identifier>()) {
-      vars.push_back(VarDecl::Create(GetASTContext(), SourceRange(), nullptr,
-                                     declarator.GetType(),
-                                     CurrentToken().GetAsString()));
+      decls.push_back(VarDecl::Create(GetASTContext(), SourceRange(), nullptr,
+                                      declarator.GetType(),
+                                      CurrentToken().GetIdentifierInfo()));
       MustConsumeToken(TokenKind::Identifier);
     }
   }
@@ -704,11 +755,10 @@ std::vector<Decl*> Parser::ParseDeclaration(Declarator& declarator) {
   // FIXME: Just a note, we need to check its redefinition.
   if (TryConsumeToken(TokenKind::Equal)) {
     Expr* init = ParseAssignmentExpr();
-    std::for_each(vars.begin(), vars.end(),
-                  [=](Decl* var) { var->As<VarDecl>()->SetInit(init); });
+    std::for_each(decls.begin() + first, decls.end(),
+                  [=](Decl* var) { cast<VarDecl>(var)->SetInit(init); });
   }
   MustConsumeToken(TokenKind::Semi);  // Eat ';'
-  return vars;
 }
 
 Expr* Parser::ParseAssignmentExpr() {
@@ -726,8 +776,18 @@ Expr* Parser::ParseCastExpr() {
   // UnaryExpr, CastExpr, PrimaryExpr...
   switch (kind) {
     case TokenKind::NumericConstant: {
-      // FIXME: This is not right for floating numbers.
-      int value = std::stoi(CurrentToken().GetData());
+      // Only look at the spelling, the data of the token runs up to the end
+      // of the file, which std::stoi would copy for every literal.
+      std::string_view spelling = CurrentToken().GetStrView();
+      const char* end = spelling.data() + spelling.size();
+      int value = 0;
+      auto [ptr, ec] = std::from_chars(spelling.data(), end, value);
+      // FIXME: This is not right for floating numbers, they're truncated.
+      const bool floating =
+          spelling.find_first_of(".eE") != std::string_view::npos;
+      if (ec != std::errc() || (ptr != end && !floating)) {
+        jcc_unreachable(fmt::format("Invalid integer literal: {}!", spelling));
+      }
       ConsumeToken();
       result = IntergerLiteral::Create(GetASTContext(), SourceRange(),
                                        GetASTContext().GetIntType(), value);
@@ -735,14 +795,14 @@ Expr* Parser::ParseCastExpr() {
     }
     case TokenKind::StringLiteral: {
       result = StringLiteral::Create(GetASTContext(), SourceRange(),
-                                     CurrentToken().GetAsString());
+                                     CurrentToken().GetStrView());
       ConsumeToken();
       break;
     }
     case TokenKind::Char: {
       result = CharacterLiteral::Create(GetASTContext(), SourceRange(),
                                         GetASTContext().GetCharType(),
-                                        CurrentToken().GetAsString());
+                                        CurrentToken().GetStrView());
       ConsumeToken();
       break;
     }
@@ -755,11 +815,10 @@ Expr* Parser::ParseCastExpr() {
       return result;
     }
     case TokenKind::Identifier: {
-      std::string name = CurrentToken().GetAsString();
+      IdentifierInfo* name = CurrentToken().GetIdentifierInfo();
       ConsumeToken();
       // Lookup the identifier and find where it comes from.
       if (auto* decl = Lookup(name)) {
-        auto* var = decl->As<VarDecl>();
         result = DeclRefExpr::Create(GetASTContext(), SourceRange(),
                                      decl->GetType(), decl);
       } else {
@@ -773,16 +832,14 @@ Expr* Parser::ParseCastExpr() {
   return ParsePostfixExpr(result);
 }
 
-std::vector<Expr*> Parser::ParseExprList() {
-  std::vector<Expr*> expr_list;
+void Parser::ParseExprList(SmallVectorImpl<Expr*>& exprs) {
   while (true) {
-    expr_list.push_back(ParseAssignmentExpr());
+    exprs.push_back(ParseAssignmentExpr());
     if (!CurrentToken().Is<TokenKind::Comma>()) {
       break;
     }
     MustConsumeToken(TokenKind::Comma);
   }
-  return expr_list;
 }
 
 Expr* Parser::ParsePostfixExpr(Expr* lhs) {
@@ -790,16 +847,14 @@ Expr* Parser::ParsePostfixExpr(Expr* lhs) {
     switch (CurrentToken().GetKind()) {
       case TokenKind::LeftParen: {
         ConsumeToken();
-        std::vector<Expr*> args;
+        SmallVector<Expr*, 8> args;
         if (!CurrentToken().Is<TokenKind::RightParen>()) {
-          args = ParseExprList();
+          ParseExprList(args);
         }
-        Type* type = lhs->As<DeclRefExpr>()
-                         ->GetRefDecl()
-                         ->As<FunctionDecl>()
-                         ->GetReturnType();
-        lhs = CallExpr::Create(GetASTContext(), SourceRange(), type, lhs,
-                               std::move(args));
+        Type* type =
+            cast<FunctionDecl>(cast<DeclRefExpr>(lhs)->GetRefDecl())
+                ->GetReturnType();
+        lhs = CallExpr::Create(GetASTContext(), SourceRange(), type, lhs, args);
         MustConsumeToken(TokenKind::RightParen);
         break;
       }
@@ -913,7 +968,7 @@ std::vector<Decl*> Parser::ParseFunctionOrVar(DeclSpec& decl_spec) {
     // here. More importantly, we're not synthesized the type of a function
     // until parsing itself, thus we need to do two sanity checks here.
     if (type != nullptr && type->IsOneOf<TypeKind::Struct, TypeKind::Union, TypeKind::Enum>()) {
-      GetCurScope().PushType(type->GetNameAsString(), type);
+      GetASTContext().PushType(type->GetName(), type);
     }
     return decls;
   }
@@ -923,7 +978,8 @@ std::vector<Decl*> Parser::ParseFunctionOrVar(DeclSpec& decl_spec) {
     Decl* func = ParseFunction(declarator);
     decls.push_back(func);
   } else {
-    std::vector<Decl*> vars = ParseDeclaration(declarator);
+    SmallVector<Decl*, 4> vars;
+    ParseDeclaration(declarator, vars);
     decls.insert(decls.end(), vars.begin(), vars.end());
   }
   return decls;
@@ -938,8 +994,8 @@ void Parser::ParseTypedef(DeclSpec& decl_spec) {
     }
     assert(CurrentToken().GetKind() == TokenKind::Identifier &&
            "Not an identifier in parsing typedef?");
-    std::string ident = CurrentToken().GetAsString();
-    GetCurScope().PushType(ident, decl_spec.GetType());
+    GetASTContext().PushType(CurrentToken().GetIdentifierInfo(),
+                             decl_spec.GetType());
     ConsumeToken();
   }
   MustConsumeToken(TokenKind::Semi);
@@ -0,0 +1,53 @@
+#include "jcc/source_manager.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <utility>
+
+#include "jcc/common.h"
+
+namespace jcc {
+
+FileID SourceManager::AddBuffer(std::string name, std::string_view buffer) {
+  // One past the end is a valid location too, that's where Eof lives.
+  if (buffer.size() >= std::numeric_limits<std::uint32_t>::max() - next_base_) {
+    jcc_unreachable("Ran out of source locations!");
+  }
+  files_.push_back({std::move(name), buffer, next_base_, std::nullopt});
+  next_base_ += buffer.size() + 1;
+  return FileID(files_.size());
+}
+
+FileID SourceManager::GetFileID(SourceLocation loc) const {
+  assert(loc.IsValid() && "Invalid location has no file!");
+  // The last file starting at or before `loc`.
+  auto next = std::upper_bound(
+      files_.begin(), files_.end(), loc.GetOffset(),
+      [](std::uint32_t offset, const FileInfo& info) {
+        return offset < info.base;
+      });
+  return FileID(next - files_.begin());
+}
+
+std::uint32_t SourceManager::GetFileOffset(SourceLocation loc) const {
+  return loc.GetOffset() - GetFileInfo(GetFileID(loc)).base;
+}
+
+std::size_t SourceManager::GetLineNumber(SourceLocation loc) const {
+  const FileInfo& info = GetFileInfo(GetFileID(loc));
+  return GetLineTable(info).GetLineNumber(loc.GetOffset() - info.base);
+}
+
+std::size_t SourceManager::GetColumnNumber(SourceLocation loc) const {
+  const FileInfo& info = GetFileInfo(GetFileID(loc));
+  return GetLineTable(info).GetColumnNumber(loc.GetOffset() - info.base);
+}
+
+const LineTable& SourceManager::GetLineTable(const FileInfo& info) const {
+  if (!info.lines) {
+    info.lines.emplace(info.buffer);
+  }
+  return *info.lines;
+}
+}  // namespace jcc
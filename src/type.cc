@@ -1,23 +1,19 @@
 #include "jcc/type.h"
 
+#include <cassert>
+#include <cstdint>
+
 #include "jcc/ast_context.h"
 #include "jcc/common.h"
 
 namespace jcc {
 
-// Pin the vtable here.
-Type::~Type() = default;
-
-ArrayType::~ArrayType() = default;
-
-PointerType::~PointerType() = default;
-
-RecordType::~RecordType() = default;
-
-FunctionType::~FunctionType() = default;
+static_assert(sizeof(Type) <= 32, "Type is touched all over codegen!");
 
 bool Type::IsCompatible(const Type& lhs, const Type& rhs) {
-  if (&lhs == &rhs) {
+  // Types are uniqued, so equal types are the same object, and qualified
+  // types share the object they were derived from.
+  if (&lhs == &rhs || lhs.GetOrigin() == rhs.GetOrigin()) {
     return true;
   }
 
@@ -25,8 +21,6 @@ bool Type::IsCompatible(const Type& lhs, const Type& rhs) {
     return true;
   }
 
-  // TODO(Jun): Consider origin type?
-
   switch (lhs.GetKind()) {
     using enum TypeKind;
     case Char:
@@ -58,54 +52,6 @@ Type* Type::CreateEnumType(ASTContext& ctx) {
   return new (mem) Type(TypeKind::Enum, 4, 4);
 }
 
-#define INIT_TYPE(KIND, SIZE, ALIGN) \
-  void* mem = ctx.Allocate<Type>();  \
-  return new (mem) Type(KIND, SIZE, ALIGN);
-
-Type* Type::CreateVoidType(ASTContext& ctx){INIT_TYPE(TypeKind::Void, 2, 1)}
-
-Type* Type::CreateCharType(ASTContext& ctx, bool is_unsigned) {
-  void* mem = ctx.Allocate<Type>();
-  Type* type = new (mem) Type(TypeKind::Char, 1, 1);
-  type->SetUnsigned(is_unsigned);
-  return type;
-}
-
-Type* Type::CreateShortType(ASTContext& ctx, bool is_unsigned) {
-  void* mem = ctx.Allocate<Type>();
-  Type* type = new (mem) Type(TypeKind::Short, 2, 2);
-  type->SetUnsigned(is_unsigned);
-  return type;
-}
-
-Type* Type::CreateBoolType(ASTContext& ctx) {
-  void* mem = ctx.Allocate<Type>();
-  Type* type = new (mem) Type(TypeKind::Bool, 1, 1);
-  return type;
-}
-
-Type* Type::CreateIntType(ASTContext& ctx, bool is_unsigned) {
-  void* mem = ctx.Allocate<Type>();
-  Type* type = new (mem) Type(TypeKind::Int, 4, 4);
-  type->SetUnsigned(is_unsigned);
-  return type;
-}
-
-Type* Type::CreateLongType(ASTContext& ctx, bool is_unsigned) {
-  void* mem = ctx.Allocate<Type>();
-  Type* type = new (mem) Type(TypeKind::Long, 8, 8);
-  type->SetUnsigned(is_unsigned);
-  return type;
-}
-
-Type* Type::CreateFloatType(ASTContext& ctx){INIT_TYPE(TypeKind::Float, 4, 4)}
-
-Type* Type::CreateDoubleType(ASTContext& ctx, bool is_long) {
-  size_t size_and_alignment = is_long ? 16 : 8;
-  INIT_TYPE(TypeKind::Double, size_and_alignment, size_and_alignment)
-}
-#undef INIT_TYPE
-
 Type* Type::CreatePointerType(ASTContext& ctx, Type* base) {
   void* mem = ctx.Allocate<PointerType>();
   auto* type = new (mem) PointerType(TypeKind::Ptr, 8, 8);
@@ -114,18 +60,25 @@ Type* Type::CreatePointerType(ASTContext& ctx, Type* base) {
   return type;
 }
 
-Type* Type::CreateFuncType(ASTContext& ctx, Type* return_type) {
+Type* Type::CreateFuncType(ASTContext& ctx, Type* return_type,
+                           std::span<Type* const> params) {
   void* mem = ctx.Allocate<FunctionType>();
   auto* type = new (mem) FunctionType(TypeKind::Func, 1, 1);
 
   type->SetReturnType(return_type);
+  type->SetParams(ctx.CopyArray<Type*>(params));
   return type;
 }
 
 Type* Type::CreateArrayType(ASTContext& ctx, Type* base, std::size_t len) {
+  // Sizes are 32 bits wide.
+  if (len != 0 && base->GetSize() > UINT32_MAX / len) {
+    jcc_unreachable("Array is too large!");
+  }
   void* mem = ctx.Allocate<ArrayType>();
-  auto* type = new (mem)
-      ArrayType(TypeKind::Array, base->GetSize() * len, base->GetAlignment());
+  auto* type = new (mem) ArrayType(
+      TypeKind::Array, static_cast<std::uint32_t>(base->GetSize() * len),
+      static_cast<std::uint32_t>(base->GetAlignment()));
   type->SetBase(base);
   type->SetLength(len);
   return type;
@@ -135,4 +88,20 @@ Type* Type::CreateRecordType(ASTContext& ctx, TypeKind kind) {
   void* mem = ctx.Allocate<RecordType>();
   return new (mem) RecordType(kind, 0, 1);
 }
+
+Type* Type::CreateQualifiedType(ASTContext& ctx, Type* base, Qualifiers quals,
+                                bool is_static) {
+  assert((base->IsOneOf<TypeKind::Void, TypeKind::Bool, TypeKind::Char,
+                        TypeKind::Short, TypeKind::Int, TypeKind::Long,
+                        TypeKind::Float, TypeKind::Double>()) &&
+         "Only builtin types can be copied!");
+  void* mem = ctx.Allocate<Type>();
+  Type* type = new (mem) Type(*base);
+  type->SetQualifiers(quals);
+  if (is_static) {
+    type->SetStatic();
+  }
+  type->origin_ = base;
+  return type;
+}
 }  // namespace jcc
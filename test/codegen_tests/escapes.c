@@ -0,0 +1,10 @@
+int puts(const char* c);
+int putchar(int c);
+
+int main() {
+  putchar('\x41');
+  putchar('\'');
+  putchar('\n');
+  puts("a\tb\"c\\d\101");
+  return 0;
+}
@@ -3,6 +3,7 @@
 import os
 from pathlib import Path
 import subprocess
+import sys
 
 EXE = "../../build/bin/jcc"
 
@@ -16,17 +17,22 @@ def list_all_tests():
     return tests
 
 
-def run_test(test_file):
+# Runs the test in memory with `--run`, or links an executable first.
+def run_test(test_file, link):
     steam = Path(test_file).stem
     expected = steam + ".out"
     bin = steam + ".bin"
-    subprocess.run(
-        [EXE, test_file, "-o", bin],
-        stdout=subprocess.DEVNULL,
-        stderr=subprocess.DEVNULL,
-    )
+    if link:
+        subprocess.run(
+            [EXE, test_file, "-o", bin],
+            stdout=subprocess.DEVNULL,
+            stderr=subprocess.DEVNULL,
+        )
+        command = [f"./{bin}"]
+    else:
+        command = [EXE, "--run", test_file]
     actual = subprocess.run(
-        [f"./{bin}"],
+        command,
         stdout=subprocess.PIPE,
         stderr=subprocess.PIPE,
         text=True,
@@ -55,6 +61,7 @@ def cleanup():
                 os.remove(file)
 
 if __name__ == "__main__":
+    link = "--link" in sys.argv[1:]
     for test_file in list_all_tests():
-        run_test(test_file)
+        run_test(test_file, link)
     cleanup()
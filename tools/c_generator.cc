@@ -0,0 +1,265 @@
+#include "c_generator.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace jcc {
+
+namespace {
+
+// Identifiers can't contain digits yet, so names are numbered in base 26
+// with letters.
+std::string Name(std::string_view prefix, std::size_t index) {
+  std::string name(prefix);
+  do {
+    name.push_back(static_cast<char>('a' + index % 26));
+    index /= 26;
+  } while (index != 0);
+  return name;
+}
+
+class Generator {
+  const GeneratorOptions& options_;
+  std::uint64_t state_;
+  std::string out_;
+  int indent_ = 0;
+
+  std::size_t num_functions_ = 0;
+  // Locals of the current function, which names them.
+  std::size_t num_locals_ = 0;
+  // The variables in scope, the parameters first.
+  std::vector<std::string> readable_;
+  // The variables in scope statements may assign to. Loop counters aren't
+  // among them, so that loops terminate.
+  std::vector<std::string> values_;
+
+ public:
+  explicit Generator(const GeneratorOptions& options)
+      : options_(options), state_(options.seed) {}
+
+  GeneratedProgram Generate() {
+    if (options_.strings > 0) {
+      out_ += "int puts(const char* s);\n\n";
+    }
+    while (num_functions_ < options_.functions ||
+           out_.size() < options_.min_size) {
+      GenerateFunction();
+    }
+    out_ += "int main() { return 0; }\n";
+    return {std::move(out_), num_functions_ + 1};
+  }
+
+ private:
+  // splitmix64. Unlike the distributions of <random>, it gives the same
+  // numbers with every standard library.
+  std::uint64_t Next() {
+    std::uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  // A number in [0, bound).
+  std::size_t Below(std::size_t bound) { return Next() % bound; }
+
+  void StartLine() { out_.append(static_cast<std::size_t>(indent_) * 2, ' '); }
+
+  std::string NewLocal(std::string_view prefix) {
+    return Name(prefix, num_locals_++);
+  }
+
+  void GenerateFunction() {
+    const std::string name = Name("fn_", num_functions_);
+    out_ += "int " + name + "(int a, int b) {\n";
+    indent_ = 1;
+    num_locals_ = 0;
+    readable_ = {"a", "b"};
+    values_.clear();
+
+    GenerateStatements(/*depth=*/0);
+    for (int i = 0; i < options_.strings; i++) {
+      StartLine();
+      out_ += "puts(";
+      GenerateString();
+      out_ += ");\n";
+    }
+    StartLine();
+    out_ += "return ";
+    GenerateExpr();
+    out_ += ";\n}\n\n";
+    // Only now it can be called, there's no recursion.
+    num_functions_++;
+  }
+
+  // The statements of a block, whose variables go out of scope at its end.
+  void GenerateStatements(int depth) {
+    const std::size_t num_readable = readable_.size();
+    const std::size_t num_values = values_.size();
+    for (int i = 0; i < options_.statements; i++) {
+      GenerateStatement(depth);
+    }
+    readable_.resize(num_readable);
+    values_.resize(num_values);
+  }
+
+  // A `{`, which must already be written, and the block up to its `}`.
+  void GenerateBlock(int depth) {
+    out_ += "{\n";
+    indent_++;
+    GenerateStatements(depth + 1);
+    indent_--;
+    StartLine();
+    out_ += "}";
+  }
+
+  void GenerateStatement(int depth) {
+    enum { Decl, Assign, If, While, For, Switch, NumKinds };
+    int kind = static_cast<int>(Below(NumKinds));
+    if (kind >= If && depth >= options_.max_depth) {
+      kind = Assign;
+    }
+    if (kind == Switch && options_.switch_cases == 0) {
+      kind = If;
+    }
+    if (kind == Assign && values_.empty()) {
+      kind = Decl;
+    }
+
+    StartLine();
+    switch (kind) {
+      case Decl: {
+        std::string name = NewLocal("v_");
+        out_ += "int " + name + " = ";
+        GenerateExpr();
+        out_ += ";\n";
+        readable_.push_back(name);
+        values_.push_back(std::move(name));
+        break;
+      }
+      case Assign:
+        out_ += values_[Below(values_.size())] + " = ";
+        GenerateExpr();
+        out_ += ";\n";
+        break;
+      case If:
+        out_ += "if (";
+        GenerateCondition();
+        out_ += ") ";
+        GenerateBlock(depth);
+        // Always with an else, the AST dumper can't do without.
+        out_ += " else ";
+        GenerateBlock(depth);
+        out_ += "\n";
+        break;
+      case While: {
+        const std::string counter = NewLocal("i_");
+        const std::string bound = std::to_string(1 + Below(8));
+        out_ += "int " + counter + " = 0;\n";
+        StartLine();
+        out_ += "while (" + counter + " < " + bound + ") {\n";
+        readable_.push_back(counter);
+        indent_++;
+        GenerateStatements(depth + 1);
+        StartLine();
+        out_ += counter + " = " + counter + " + 1;\n";
+        indent_--;
+        readable_.pop_back();
+        StartLine();
+        out_ += "}\n";
+        break;
+      }
+      case For: {
+        const std::string counter = NewLocal("i_");
+        const std::string bound = std::to_string(1 + Below(8));
+        out_ += "int " + counter + " = 0;\n";
+        StartLine();
+        out_ += "for (" + counter + " = 0; " + counter + " < " + bound + "; " +
+                counter + "++) ";
+        readable_.push_back(counter);
+        GenerateBlock(depth);
+        readable_.pop_back();
+        out_ += "\n";
+        break;
+      }
+      case Switch:
+        out_ += "switch (" + readable_[Below(readable_.size())] + ") {\n";
+        for (int i = 0; i <= options_.switch_cases; i++) {
+          StartLine();
+          out_ += i < options_.switch_cases
+                      ? "  case " + std::to_string(i) + ": "
+                      : std::string("  default: ");
+          indent_++;
+          GenerateBlock(depth);
+          indent_--;
+          out_ += "\n";
+        }
+        StartLine();
+        out_ += "}\n";
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Compares an expression with a single operand.
+  void GenerateCondition() {
+    GenerateExpr();
+    out_ += Below(2) == 0 ? " < " : " > ";
+    GenerateLeaf();
+  }
+
+  void GenerateExpr() {
+    for (int i = 0; i < options_.expr_size; i++) {
+      if (i != 0) {
+        out_ += " + ";
+      }
+      GenerateOperand();
+    }
+  }
+
+  void GenerateOperand() {
+    // One operand in eight calls an earlier function.
+    if (num_functions_ != 0 && Below(8) == 0) {
+      out_ += Name("fn_", Below(num_functions_)) + "(";
+      GenerateLeaf();
+      out_ += ", ";
+      GenerateLeaf();
+      out_ += ")";
+      return;
+    }
+    GenerateLeaf();
+  }
+
+  // An integer literal or a variable.
+  void GenerateLeaf() {
+    if (Below(3) == 0) {
+      out_ += std::to_string(Below(1000));
+      return;
+    }
+    out_ += readable_[Below(readable_.size())];
+  }
+
+  // Mostly letters and spaces, with an escape now and then.
+  void GenerateString() {
+    static constexpr std::string_view chars =
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ ,.;:!?-+*/()";
+    out_ += '"';
+    for (std::size_t i = 0; i < options_.string_length; i++) {
+      if (Below(32) == 0) {
+        out_ += Below(2) == 0 ? "\\n" : "\\t";
+      } else {
+        out_ += chars[Below(chars.size())];
+      }
+    }
+    out_ += '"';
+  }
+};
+}  // namespace
+
+GeneratedProgram GenerateProgram(const GeneratorOptions& options) {
+  return Generator(options).Generate();
+}
+}  // namespace jcc
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace jcc {
+
+// Knobs of GenerateProgram. The defaults make functions of about a hundred
+// lines.
+struct GeneratorOptions {
+  // The same options and seed always give the same program.
+  std::uint64_t seed = 1;
+  std::size_t functions = 16;
+  // Keeps adding functions past `functions` until the source is at least
+  // this many bytes.
+  std::size_t min_size = 0;
+  // Statements in each block, before the nested ones are counted.
+  int statements = 4;
+  // How deep if, while, for and switch statements nest inside a function.
+  int max_depth = 2;
+  // Operands in each expression, which are literals, variables and calls
+  // to the functions generated before.
+  int expr_size = 4;
+  // Cases of each switch statement, besides the default. No switch
+  // statements at all if it's 0.
+  int switch_cases = 4;
+  // String literals passed to puts() in each function, and their length.
+  int strings = 1;
+  std::size_t string_length = 16;
+};
+
+struct GeneratedProgram {
+  std::string source;
+  std::size_t num_functions;
+};
+
+// Generates a translation unit in the subset of C jcc compiles, for
+// stressing the compiler on inputs of any size and shape.
+//
+// Programs are only meant to be compiled: every loop terminates, but calls
+// nest inside loops, so running a large one can take forever.
+GeneratedProgram GenerateProgram(const GeneratorOptions& options);
+}  // namespace jcc
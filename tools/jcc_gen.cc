@@ -0,0 +1,55 @@
+// Prints a generated C program, e.g. to time the whole compiler on it:
+//
+//   jcc_gen --size=10000000 | jcc - -S
+#include <fmt/format.h>
+
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+
+#include "c_generator.h"
+
+template <typename T>
+static bool ParseNumber(std::string_view text, T& value) {
+  auto [ptr, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  return error == std::errc() && ptr == text.data() + text.size();
+}
+
+int main(int argc, char** argv) {
+  jcc::GeneratorOptions options;
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    const std::size_t equal = arg.find('=');
+    std::string_view name = arg.substr(0, equal);
+    std::string_view value =
+        equal == std::string_view::npos ? "" : arg.substr(equal + 1);
+
+    bool ok = false;
+    if (name == "--seed") {
+      ok = ParseNumber(value, options.seed);
+    } else if (name == "--functions") {
+      ok = ParseNumber(value, options.functions);
+    } else if (name == "--size") {
+      ok = ParseNumber(value, options.min_size);
+    } else if (name == "--statements") {
+      ok = ParseNumber(value, options.statements);
+    } else if (name == "--depth") {
+      ok = ParseNumber(value, options.max_depth);
+    } else if (name == "--expr-size") {
+      ok = ParseNumber(value, options.expr_size);
+    } else if (name == "--switch-cases") {
+      ok = ParseNumber(value, options.switch_cases);
+    } else if (name == "--strings") {
+      ok = ParseNumber(value, options.strings);
+    } else if (name == "--string-length") {
+      ok = ParseNumber(value, options.string_length);
+    }
+    if (!ok) {
+      fmt::print(stderr, "Bad argument: {}!\n", arg);
+      return 1;
+    }
+  }
+  fmt::print("{}", jcc::GenerateProgram(options).source);
+  return 0;
+}
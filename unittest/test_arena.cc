@@ -0,0 +1,57 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "gtest/gtest.h"
+#include "jcc/allocator.h"
+
+static bool IsAligned(const void* ptr) {
+  return (reinterpret_cast<std::uintptr_t>(ptr) &
+          (alignof(std::max_align_t) - 1)) == 0;
+}
+
+TEST(ArenaTest, Small) {
+  jcc::Arena arena;
+  void* first = arena.AllocateAligned(1);
+  void* second = arena.AllocateAligned(16);
+  EXPECT_TRUE(IsAligned(first));
+  EXPECT_TRUE(IsAligned(second));
+  EXPECT_EQ(static_cast<std::byte*>(first) + alignof(std::max_align_t),
+            second);
+  EXPECT_EQ(1u, arena.GetNumChunks());
+  EXPECT_EQ(17u, arena.GetBytesRequested());
+  EXPECT_EQ(alignof(std::max_align_t) - 1, arena.GetBytesPadding());
+}
+
+// Used to return null past 64KiB.
+TEST(ArenaTest, Large) {
+  jcc::Arena arena;
+  void* small = arena.AllocateAligned(8);
+  const std::size_t available = arena.AvailableSize();
+
+  constexpr std::size_t size = 1 << 20;
+  auto* large = static_cast<std::byte*>(arena.AllocateAligned(size));
+  ASSERT_NE(nullptr, large);
+  EXPECT_TRUE(IsAligned(large));
+  std::memset(large, 0xff, size);
+
+  // The current chunk is left to small allocations.
+  EXPECT_EQ(available, arena.AvailableSize());
+  EXPECT_EQ(static_cast<std::byte*>(small) + 16, arena.AllocateAligned(8));
+  EXPECT_EQ(2u, arena.GetNumChunks());
+}
+
+TEST(ArenaTest, Reset) {
+  jcc::Arena arena;
+  void* first = arena.AllocateAligned(64);
+  for (int i = 0; i < 1000; i++) {
+    arena.AllocateAligned(100);
+  }
+  arena.AllocateAligned(1 << 20);
+  EXPECT_LT(3u, arena.GetNumChunks());
+
+  arena.Reset();
+  EXPECT_EQ(1u, arena.GetNumChunks());
+  EXPECT_EQ(0u, arena.GetBytesRequested());
+  EXPECT_EQ(first, arena.AllocateAligned(64));
+}
@@ -0,0 +1,79 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "jcc/asm_writer.h"
+
+class AsmWriterTest : public ::testing::Test {
+ protected:
+  std::filesystem::path path_ =
+      std::filesystem::temp_directory_path() / "jcc_asm_writer_test.s";
+  int fd_ = -1;
+
+  void SetUp() override {
+    fd_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd_, 0);
+  }
+
+  void TearDown() override {
+    close(fd_);
+    std::filesystem::remove(path_);
+  }
+
+  std::string ReadOutput() const {
+    std::ifstream in(path_);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+  }
+};
+
+TEST_F(AsmWriterTest, Lines) {
+  jcc::AsmWriter out(fd_, path_.parent_path());
+  out.Directive(".globl {}", "main");
+  out.Label("{}", "main");
+  out.Instr("mov ${}, %rax", 42);
+  out.Label(".L.return.{}", "main");
+  out.Instr("ret");
+  out.Finish();
+  EXPECT_EQ("  .globl main\nmain:\n  mov $42, %rax\n.L.return.main:\n  ret\n",
+            ReadOutput());
+}
+
+// The header comes first and the data last, whatever the order they were
+// written in. Enough is written for the text to be streamed and the data
+// to be spilled to a temporary file a few times.
+TEST_F(AsmWriterTest, Sections) {
+  using Section = jcc::AsmWriter::Section;
+  jcc::AsmWriter out(fd_, path_.parent_path());
+  std::string header;
+  std::string data;
+  std::string text;
+
+  out.SetSection(Section::Header);
+  out.Directive(R"(.file "{}")", "test.c");
+  header += "  .file \"test.c\"\n";
+  for (int i = 0; i < 100000; i++) {
+    out.SetSection(Section::Text);
+    out.Label("fn_{}", i);
+    text += fmt::format("fn_{}:\n", i);
+    out.SetSection(Section::Data);
+    out.Directive(".byte {}", i % 128);
+    out.Directive(".ascii \"{}\"", std::string(i % 64, 'x'));
+    data += fmt::format("  .byte {}\n", i % 128);
+    data += fmt::format("  .ascii \"{}\"\n", std::string(i % 64, 'x'));
+    out.SetSection(Section::Text);
+    out.Instr("ret");
+    text += "  ret\n";
+    out.Flush();
+  }
+  EXPECT_GT(std::filesystem::file_size(path_), 0);
+  out.Finish();
+  EXPECT_EQ(header + text + data, ReadOutput());
+}
@@ -0,0 +1,189 @@
+#include <elf.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "jcc/asm_writer.h"
+#include "jcc/assembler.h"
+#include "jcc/elf_writer.h"
+
+static jcc::ObjectFile Assemble(std::string_view text) {
+  jcc::Assembler assembler;
+  assembler.Assemble(text);
+  return assembler.Finish();
+}
+
+static std::vector<std::uint8_t> Encode(std::string_view line) {
+  const std::string text = Assemble(line).sections[0].data;
+  return {text.begin(), text.end()};
+}
+
+static const jcc::ObjectSymbol* FindSymbol(const jcc::ObjectFile& object,
+                                           std::string_view name) {
+  for (const jcc::ObjectSymbol& symbol : object.symbols) {
+    if (symbol.name == name) {
+      return &symbol;
+    }
+  }
+  return nullptr;
+}
+
+// What GNU as encodes them to.
+TEST(AssemblerTest, Encoding) {
+  using Bytes = std::vector<std::uint8_t>;
+  EXPECT_EQ(Bytes({0x50}), Encode("push %rax"));
+  EXPECT_EQ(Bytes({0x41, 0x59}), Encode("pop %r9"));
+  EXPECT_EQ(Bytes({0xc3}), Encode("ret"));
+  EXPECT_EQ(Bytes({0x48, 0x89, 0xe5}), Encode("mov %rsp, %rbp"));
+  EXPECT_EQ(Bytes({0x49, 0x89, 0xc2}), Encode("mov %rax, %r10"));
+  EXPECT_EQ(Bytes({0x89, 0x07}), Encode("mov %eax, (%rdi)"));
+  EXPECT_EQ(Bytes({0x48, 0x8b, 0x00}), Encode("mov (%rax), %rax"));
+  EXPECT_EQ(Bytes({0x4c, 0x8b, 0x24, 0x24}), Encode("mov (%rsp), %r12"));
+  EXPECT_EQ(Bytes({0x44, 0x89, 0x4d, 0xe8}), Encode("mov %r9d, -24(%rbp)"));
+  EXPECT_EQ(Bytes({0xb8, 0x01, 0x00, 0x00, 0x00}), Encode("mov $1, %eax"));
+  EXPECT_EQ(Bytes({0x48, 0xc7, 0xc0, 0xff, 0xff, 0xff, 0xff}),
+            Encode("mov $-1, %rax"));
+  EXPECT_EQ(Bytes({0x48, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00}),
+            Encode("mov $4294967296, %rax"));
+  EXPECT_EQ(Bytes({0x48, 0x63, 0x00}), Encode("movsxd (%rax), %rax"));
+  EXPECT_EQ(Bytes({0x48, 0x0f, 0xb6, 0xc0}), Encode("movzb %al, %rax"));
+  EXPECT_EQ(Bytes({0x48, 0x8d, 0x45, 0xf8}), Encode("lea -8(%rbp), %rax"));
+  EXPECT_EQ(Bytes({0x48, 0x8d, 0x85, 0x00, 0xfc, 0xff, 0xff}),
+            Encode("lea -1024(%rbp), %rax"));
+  EXPECT_EQ(Bytes({0x49, 0x8d, 0x45, 0x08}), Encode("lea 8(%r13), %rax"));
+  EXPECT_EQ(Bytes({0x48, 0x83, 0xec, 0x10}), Encode("sub $16, %rsp"));
+  EXPECT_EQ(Bytes({0x48, 0x81, 0xec, 0x00, 0x04, 0x00, 0x00}),
+            Encode("sub $1024, %rsp"));
+  EXPECT_EQ(Bytes({0x83, 0x45, 0xfc, 0x01}), Encode("addl $1, -4(%rbp)"));
+  EXPECT_EQ(Bytes({0x01, 0xf8}), Encode("add %edi, %eax"));
+  EXPECT_EQ(Bytes({0x39, 0xf8}), Encode("cmp %edi, %eax"));
+  EXPECT_EQ(Bytes({0x48, 0x83, 0xf8, 0x00}), Encode("cmp $0, %rax"));
+  EXPECT_EQ(Bytes({0x3d, 0xe8, 0x03, 0x00, 0x00}), Encode("cmp $1000, %eax"));
+  EXPECT_EQ(Bytes({0x0f, 0x9c, 0xc0}), Encode("setl %al"));
+  EXPECT_EQ(Bytes({0x40, 0x0f, 0x9c, 0xc6}), Encode("setl %sil"));
+  EXPECT_EQ(Bytes({0x41, 0xff, 0xd2}), Encode("call *%r10"));
+}
+
+TEST(AssemblerTest, Branches) {
+  jcc::ObjectFile object = Assemble(
+      ".L.begin.1:\n"
+      "  je .L.end.1\n"
+      "  jmp .L.begin.1\n"
+      ".L.end.1:\n");
+  const std::string expected(
+      "\x0f\x84\x05\x00\x00\x00"
+      "\xe9\xf5\xff\xff\xff",
+      11);
+  EXPECT_EQ(expected, object.sections[0].data);
+  EXPECT_TRUE(object.sections[0].relocations.empty());
+  // Temporary labels aren't symbols.
+  EXPECT_EQ(nullptr, FindSymbol(object, ".L.begin.1"));
+}
+
+TEST(AssemblerTest, Relocations) {
+  // Split mid-line, as the text comes in chunks.
+  jcc::Assembler assembler;
+  assembler.Assemble(
+      "  .file \"test.c\"\n"
+      "  .data\n"
+      "  .byte 1, 2\n"
+      ".L..1:\n"
+      "  .byte 0\n"
+      "  .text\n"
+      "  .globl f\n"
+      "  .type f, @function\n"
+      "f:\n"
+      "  lea .L..1(%r");
+  assembler.Assemble(
+      "ip), %rax\n"
+      "  mov puts@GOTPCREL(%rip), %rax\n"
+      "  lea f(%rip), %rax\n"
+      "  lea g(%rip), %rax\n"
+      "g:\n"
+      "  ret\n");
+  jcc::ObjectFile object = assembler.Finish();
+
+  const jcc::ObjectSymbol* f = FindSymbol(object, "f");
+  ASSERT_NE(nullptr, f);
+  EXPECT_EQ(STB_GLOBAL, f->binding);
+  EXPECT_EQ(STT_FUNC, f->type);
+  EXPECT_EQ(1, f->section);
+  const jcc::ObjectSymbol* g = FindSymbol(object, "g");
+  ASSERT_NE(nullptr, g);
+  EXPECT_EQ(STB_LOCAL, g->binding);
+  const jcc::ObjectSymbol* puts = FindSymbol(object, "puts");
+  ASSERT_NE(nullptr, puts);
+  EXPECT_EQ(STB_GLOBAL, puts->binding);
+  EXPECT_EQ(SHN_UNDEF, puts->section);
+  ASSERT_NE(nullptr, FindSymbol(object, "test.c"));
+
+  // g is local to the section, so it's resolved right away.
+  const std::string& text = object.sections[0].data;
+  ASSERT_EQ(29, text.size());
+  EXPECT_EQ(0, std::memcmp(text.data() + 24, "\x00\x00\x00\x00\xc3", 5));
+
+  const std::vector<jcc::ObjectRelocation>& relocations =
+      object.sections[0].relocations;
+  ASSERT_EQ(3, relocations.size());
+  const jcc::ObjectSymbol& data = object.symbols[relocations[0].symbol];
+  EXPECT_EQ(STT_SECTION, data.type);
+  EXPECT_EQ(2, data.section);
+  EXPECT_EQ(3, relocations[0].offset);
+  EXPECT_EQ(R_X86_64_PC32, relocations[0].type);
+  EXPECT_EQ(2 - 4, relocations[0].addend);
+  EXPECT_EQ(puts, &object.symbols[relocations[1].symbol]);
+  EXPECT_EQ(R_X86_64_GOTPCREL, relocations[1].type);
+  EXPECT_EQ(f, &object.symbols[relocations[2].symbol]);
+  EXPECT_EQ(R_X86_64_PC32, relocations[2].type);
+}
+
+TEST(ElfWriterTest, Layout) {
+  jcc::AsmBuffer buffer;
+  jcc::WriteElf(Assemble("  .globl main\n"
+                         "main:\n"
+                         "  mov puts@GOTPCREL(%rip), %rax\n"
+                         "  ret\n"),
+                buffer);
+  std::string elf;
+  buffer.Drain([&](std::string_view chunk) {
+    elf += chunk;
+    return true;
+  });
+
+  Elf64_Ehdr header;
+  ASSERT_GE(elf.size(), sizeof(header));
+  std::memcpy(&header, elf.data(), sizeof(header));
+  EXPECT_EQ(0, std::memcmp(header.e_ident, ELFMAG, SELFMAG));
+  EXPECT_EQ(ET_REL, header.e_type);
+  EXPECT_EQ(EM_X86_64, header.e_machine);
+  ASSERT_EQ(header.e_shoff + header.e_shnum * sizeof(Elf64_Shdr), elf.size());
+
+  std::vector<Elf64_Shdr> sections(header.e_shnum);
+  std::memcpy(sections.data(), elf.data() + header.e_shoff,
+              sections.size() * sizeof(Elf64_Shdr));
+  const char* names = elf.data() + sections[header.e_shstrndx].sh_offset;
+  std::vector<std::string> section_names;
+  for (const Elf64_Shdr& section : sections) {
+    section_names.emplace_back(names + section.sh_name);
+  }
+  EXPECT_EQ(std::vector<std::string>({"", ".text", ".data", ".note.GNU-stack",
+                                      ".rela.text", ".symtab", ".strtab",
+                                      ".shstrtab"}),
+            section_names);
+
+  // Local symbols first: null, the sections, then main and puts.
+  const Elf64_Shdr& symtab = sections[5];
+  EXPECT_EQ(3, symtab.sh_info);
+  EXPECT_EQ(5 * sizeof(Elf64_Sym), symtab.sh_size);
+  const Elf64_Shdr& rela = sections[4];
+  EXPECT_EQ(5, rela.sh_link);
+  EXPECT_EQ(1, rela.sh_info);
+  Elf64_Rela relocation;
+  std::memcpy(&relocation, elf.data() + rela.sh_offset, sizeof(relocation));
+  EXPECT_EQ(R_X86_64_GOTPCREL, ELF64_R_TYPE(relocation.r_info));
+  EXPECT_EQ(4, ELF64_R_SYM(relocation.r_info));
+}
@@ -0,0 +1,90 @@
+#include <fmt/format.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "c_generator.h"
+#include "gtest/gtest.h"
+#include "jcc/codegen.h"
+#include "jcc/decl.h"
+#include "jcc/identifier_table.h"
+#include "jcc/lexer.h"
+#include "jcc/parser.h"
+#include "jcc/source_manager.h"
+
+// Compiles `source` to assembly in a temporary file, a few times, and
+// returns the fastest time in seconds. The file is named after the process,
+// so runs in parallel don't write over each other's.
+static double CompileSeconds(const std::string& source) {
+  const std::filesystem::path file =
+      std::filesystem::temp_directory_path() /
+      fmt::format("jcc_compile_time_{}.c", getpid());
+  double best = 0;
+  for (int i = 0; i < 3; i++) {
+    auto start = std::chrono::steady_clock::now();
+    jcc::SourceManager source_mgr;
+    jcc::IdentifierTable idents;
+    jcc::Lexer lexer(source_mgr, source_mgr.AddBuffer("test.c", source),
+                     idents);
+    jcc::Parser parser(lexer);
+    std::vector<jcc::Decl*> decls = parser.ParseTranslateUnit();
+    jcc::GenerateAssembly(file.string(), decls);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = i == 0 ? elapsed.count() : std::min(best, elapsed.count());
+  }
+  std::filesystem::remove(std::filesystem::path(file).replace_extension(".s"));
+  return best;
+}
+
+TEST(GeneratorTest, Deterministic) {
+  jcc::GeneratorOptions options;
+  EXPECT_EQ(jcc::GenerateProgram(options).source,
+            jcc::GenerateProgram(options).source);
+  jcc::GeneratorOptions other = options;
+  other.seed++;
+  EXPECT_NE(jcc::GenerateProgram(options).source,
+            jcc::GenerateProgram(other).source);
+
+  options.min_size = 4096;
+  jcc::GeneratedProgram program = jcc::GenerateProgram(options);
+  EXPECT_GE(program.source.size(), 4096);
+  EXPECT_GT(program.num_functions, options.functions);
+}
+
+// Compiling a program eight times as large should take about eight times
+// as long. Anything quadratic, like scanning the rest of the file for every
+// token, takes 64 times as long and fails.
+//
+// Slow and at the mercy of the machine's load, so ctest only runs it as
+// test_compile_time_linear with `ctest -C Slow`.
+TEST(CompileTimeTest, Linear) {
+  constexpr std::size_t small_size = 128 * 1024;
+  constexpr double max_ratio = 24;
+
+  std::vector<jcc::GeneratorOptions> shapes(4);
+  // Deeply nested statements.
+  shapes[1].max_depth = 4;
+  shapes[1].statements = 2;
+  // Large switch statements.
+  shapes[2].max_depth = 1;
+  shapes[2].switch_cases = 64;
+  // Lots of string literals.
+  shapes[3].strings = 16;
+  shapes[3].string_length = 64;
+
+  for (jcc::GeneratorOptions& shape : shapes) {
+    shape.min_size = small_size;
+    const double small = CompileSeconds(jcc::GenerateProgram(shape).source);
+    shape.min_size = small_size * 8;
+    const double large = CompileSeconds(jcc::GenerateProgram(shape).source);
+    EXPECT_LT(large, small * max_ratio)
+        << "depth " << shape.max_depth << ", " << shape.switch_cases
+        << " cases, " << shape.strings << " strings";
+  }
+}
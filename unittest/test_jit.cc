@@ -0,0 +1,56 @@
+#include <memory>
+#include <string_view>
+
+#include "gtest/gtest.h"
+#include "jcc/assembler.h"
+#include "jcc/jit.h"
+
+static std::unique_ptr<jcc::JitImage> Load(std::string_view text) {
+  jcc::Assembler assembler;
+  assembler.Assemble(text);
+  return jcc::JitImage::Load(assembler.Finish());
+}
+
+TEST(JitTest, Call) {
+  std::unique_ptr<jcc::JitImage> image = Load(
+      "  .data\n"
+      "value:\n"
+      "  .byte 40\n"
+      "  .text\n"
+      "  .globl get\n"
+      "get:\n"
+      "  lea value(%rip), %rax\n"
+      "  movzb (%rax), %eax\n"
+      "  add $2, %eax\n"
+      "  ret\n");
+  ASSERT_NE(nullptr, image);
+  auto get = reinterpret_cast<int (*)()>(image->GetSymbol("get"));
+  ASSERT_NE(nullptr, get);
+  EXPECT_EQ(42, get());
+  // Local symbols aren't visible.
+  EXPECT_EQ(nullptr, image->GetSymbol("value"));
+}
+
+TEST(JitTest, ExternalSymbols) {
+  // Through the GOT, and directly, which goes through a stub.
+  std::unique_ptr<jcc::JitImage> image = Load(
+      "  .globl indirect\n"
+      "indirect:\n"
+      "  mov abs@GOTPCREL(%rip), %r10\n"
+      "  call *%r10\n"
+      "  ret\n"
+      "  .globl direct\n"
+      "direct:\n"
+      "  jmp abs\n");
+  ASSERT_NE(nullptr, image);
+  auto indirect = reinterpret_cast<int (*)(int)>(image->GetSymbol("indirect"));
+  auto direct = reinterpret_cast<int (*)(int)>(image->GetSymbol("direct"));
+  ASSERT_NE(nullptr, indirect);
+  ASSERT_NE(nullptr, direct);
+  EXPECT_EQ(5, indirect(-5));
+  EXPECT_EQ(7, direct(-7));
+}
+
+TEST(JitTest, UndefinedSymbol) {
+  EXPECT_EQ(nullptr, Load("  call jcc_no_such_function\n"));
+}
@@ -1,25 +1,47 @@
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
 #include <string_view>
 
 #include "gtest/gtest.h"
+#include "jcc/char_scanner.h"
+#include "jcc/identifier_table.h"
+#include "jcc/keywords.h"
 #include "jcc/lexer.h"
+#include "jcc/line_table.h"
+#include "jcc/memory_buffer.h"
+#include "jcc/source_manager.h"
 #include "jcc/token.h"
+#include "jcc/token_buffer.h"
 
-static bool IsTokenMatch(jcc::Lexer& lexer, jcc::TokenKind kind,
-                         std::size_t line, std::size_t column) {
-  auto tok = lexer.Lex();
-  bool match = (kind == tok.GetKind() && line == tok.getLoc().GetLine() &&
-                column == tok.getLoc().GetColumn());
-  return match;
-}
+class LexerTest : public ::testing::Test {
+ protected:
+  jcc::SourceManager source_mgr_;
+  jcc::IdentifierTable idents_;
+
+  jcc::Lexer CreateLexer(std::string_view source) {
+    return {source_mgr_, source_mgr_.AddBuffer("<Buffer>", source), idents_};
+  }
 
-TEST(LexerTest, Empty) {
-  jcc::Lexer lexer{""};
+  bool IsTokenMatch(jcc::Lexer& lexer, jcc::TokenKind kind, std::size_t column,
+                    std::size_t line) {
+    auto tok = lexer.Lex();
+    bool match = (kind == tok.GetKind() &&
+                  line == source_mgr_.GetLineNumber(tok.getLoc()) &&
+                  column == source_mgr_.GetColumnNumber(tok.getLoc()));
+    return match;
+  }
+};
+
+TEST_F(LexerTest, Empty) {
+  jcc::Lexer lexer = CreateLexer("");
   EXPECT_EQ(jcc::TokenKind::Eof, lexer.Lex().GetKind());
 }
 
-TEST(LexerTest, OneLine) {
+TEST_F(LexerTest, OneLine) {
   {
-    jcc::Lexer lexer{"int main() {return 0;}"};
+    jcc::Lexer lexer = CreateLexer("int main() {return 0;}");
     EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Int, 1, 1));
     EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Identifier, 5, 1));
     EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::LeftParen, 9, 1));
@@ -34,7 +56,7 @@ TEST(LexerTest, OneLine) {
   }
 
   {
-    jcc::Lexer lexer{"int foo() { int i = 1 + 2; i++;"};
+    jcc::Lexer lexer = CreateLexer("int foo() { int i = 1 + 2; i++;");
     EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Int, 1, 1));
     EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Identifier, 5, 1));
     EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::LeftParen, 8, 1));
@@ -56,19 +78,28 @@ TEST(LexerTest, OneLine) {
   }
 
   {
-    jcc::Lexer lexer{"i "};
+    jcc::Lexer lexer = CreateLexer("i ");
 
     EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Identifier, 1, 1));
     EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Eof, 3, 1));
   }
 }
 
-TEST(LexerTest, MultipleLine) {
-  jcc::Lexer lexer{
-      R"(int main()
+// Tokens of two characters start at their first one.
+TEST_F(LexerTest, Punctuators) {
+  jcc::Lexer lexer = CreateLexer("a == b <= c");
+  EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Identifier, 1, 1));
+  EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::EqualEqual, 3, 1));
+  EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Identifier, 6, 1));
+  EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::LessEqual, 8, 1));
+  EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Identifier, 11, 1));
+}
+
+TEST_F(LexerTest, MultipleLine) {
+  jcc::Lexer lexer = CreateLexer(R"(int main()
 {
 int i = 0;
-})"};
+})");
 
   EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Int, 1, 1));
   EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Identifier, 5, 1));
@@ -84,9 +115,171 @@ int i = 0;
   EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Eof, 2, 4));
 }
 
-TEST(LexerTest, WhileNotDone) {
-  jcc::Lexer lexer{"int    foo(){ return 0;  } "};
+TEST_F(LexerTest, WhileNotDone) {
+  jcc::Lexer lexer = CreateLexer("int    foo(){ return 0;  } ");
   while (!lexer.HasDone()) {
     lexer.Lex();
   }
 }
+
+TEST_F(LexerTest, Keywords) {
+  EXPECT_EQ(jcc::TokenKind::Do, jcc::Keywords::Match("do"));
+  EXPECT_EQ(jcc::TokenKind::Int, jcc::Keywords::Match("int"));
+  EXPECT_EQ(jcc::TokenKind::Unsigned, jcc::Keywords::Match("unsigned"));
+  EXPECT_EQ(jcc::TokenKind::DashStaticAssert,
+            jcc::Keywords::Match("_Static_assert"));
+  EXPECT_EQ(std::nullopt, jcc::Keywords::Match("i"));
+  EXPECT_EQ(std::nullopt, jcc::Keywords::Match("in"));
+  EXPECT_EQ(std::nullopt, jcc::Keywords::Match("ints"));
+  EXPECT_EQ(std::nullopt, jcc::Keywords::Match("Int"));
+  EXPECT_EQ(std::nullopt, jcc::Keywords::Match("_Static_assertx"));
+
+  jcc::Lexer lexer = CreateLexer("double doubled _Bool");
+  EXPECT_EQ(jcc::TokenKind::Double, lexer.Lex().GetKind());
+  EXPECT_EQ(jcc::TokenKind::Identifier, lexer.Lex().GetKind());
+  EXPECT_EQ(jcc::TokenKind::DashBool, lexer.Lex().GetKind());
+}
+
+// Every spelling is interned once, no matter how often it shows up.
+TEST_F(LexerTest, IdentifierTable) {
+  jcc::Lexer lexer = CreateLexer("foo bar foo int");
+  jcc::Token foo = lexer.Lex();
+  jcc::Token bar = lexer.Lex();
+  jcc::Token foo_again = lexer.Lex();
+  jcc::Token keyword = lexer.Lex();
+  EXPECT_NE(foo.GetIdentifierInfo(), bar.GetIdentifierInfo());
+  EXPECT_EQ(foo.GetIdentifierInfo(), foo_again.GetIdentifierInfo());
+  EXPECT_EQ("foo", foo.GetIdentifierInfo()->GetName());
+  EXPECT_EQ("foo", foo_again.GetAsString());
+  EXPECT_FALSE(foo.GetIdentifierInfo()->IsKeyword());
+  EXPECT_TRUE(keyword.GetIdentifierInfo()->IsKeyword());
+  EXPECT_EQ(&idents_.Get("int"), keyword.GetIdentifierInfo());
+  EXPECT_EQ(3, idents_.GetSize());
+}
+
+TEST_F(LexerTest, Comment) {
+  jcc::Lexer lexer = CreateLexer(R"(int /* a ** comment
+*/ x; /**/ /* / */ y)");
+  EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Int, 1, 1));
+  EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Identifier, 4, 2));
+  EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Semi, 5, 2));
+  EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Identifier, 20, 2));
+  EXPECT_EQ(true, IsTokenMatch(lexer, jcc::TokenKind::Eof, 21, 2));
+}
+
+// LexAll must produce exactly the tokens Lex() does, one by one.
+TEST_F(LexerTest, LexAll) {
+  constexpr std::string_view source =
+      "int main(void) {\n  char* s = \"str\"; /* x */ return 'c' + 10;\n"
+      "  s->x == 1;\n}";
+  jcc::Lexer lexer = CreateLexer(source);
+  jcc::Lexer expected(source_mgr_, lexer.GetFileID(), idents_);
+  jcc::TokenBuffer tokens = lexer.LexAll();
+  ASSERT_EQ(25, tokens.GetSize());
+  for (std::size_t idx = 0; idx < tokens.GetSize(); idx++) {
+    jcc::Token token = tokens.GetToken(idx);
+    jcc::Token expected_token = expected.Lex();
+    EXPECT_EQ(expected_token.GetKind(), tokens.GetKind(idx));
+    EXPECT_EQ(expected_token.GetKind(), token.GetKind());
+    EXPECT_EQ(expected_token.GetData(), token.GetData());
+    EXPECT_EQ(expected_token.getLength(), token.getLength());
+    EXPECT_EQ(expected_token.getLoc(), token.getLoc());
+    EXPECT_EQ(expected_token.GetIdentifierInfo(), token.GetIdentifierInfo());
+  }
+  EXPECT_EQ(jcc::TokenKind::Eof, tokens.GetKind(tokens.GetSize() - 1));
+}
+
+TEST_F(LexerTest, LineTable) {
+  jcc::LineTable lines{"a\n\nbc\n"};
+  EXPECT_EQ(4, lines.GetNumLines());
+  EXPECT_EQ(1, lines.GetLineNumber(0));
+  EXPECT_EQ(1, lines.GetLineNumber(1));
+  EXPECT_EQ(2, lines.GetLineNumber(2));
+  EXPECT_EQ(3, lines.GetLineNumber(3));
+  EXPECT_EQ(2, lines.GetColumnNumber(4));
+  EXPECT_EQ(4, lines.GetLineNumber(6));
+  EXPECT_EQ(1, lines.GetColumnNumber(6));
+}
+
+// Locations from different buffers never overlap.
+TEST_F(LexerTest, SourceManager) {
+  jcc::FileID first = source_mgr_.AddBuffer("first.c", "int");
+  jcc::FileID second = source_mgr_.AddBuffer("second.c", "\n x");
+  jcc::Lexer lexer{source_mgr_, second, idents_};
+  jcc::SourceLocation loc = lexer.Lex().getLoc();
+  EXPECT_EQ(second, source_mgr_.GetFileID(loc));
+  EXPECT_EQ(2, source_mgr_.GetFileOffset(loc));
+  EXPECT_EQ(2, source_mgr_.GetLineNumber(loc));
+  EXPECT_EQ(2, source_mgr_.GetColumnNumber(loc));
+  EXPECT_EQ("second.c", source_mgr_.GetFileName(second));
+  EXPECT_EQ(first, source_mgr_.GetFileID(
+                       source_mgr_.GetLocForStartOfFile(first)
+                           .GetLocWithOffset(3)));
+}
+
+// Whatever way the file is read, the lexer must find a NUL right behind it.
+TEST_F(LexerTest, MemoryBuffer) {
+  const std::string path = ::testing::TempDir() + "jcc_memory_buffer.c";
+  const std::size_t page_size = sysconf(_SC_PAGESIZE);
+  for (std::size_t size : {std::size_t{0}, std::size_t{100}, 8 * page_size,
+                           8 * page_size + 1}) {
+    std::string source(size, 'x');
+    FILE* file = fopen(path.c_str(), "w");
+    ASSERT_NE(nullptr, file);
+    fwrite(source.data(), 1, source.size(), file);
+    fclose(file);
+
+    auto buffer = jcc::MemoryBuffer::GetFile(path);
+    ASSERT_NE(nullptr, buffer);
+    EXPECT_EQ(size >= 8 * page_size, buffer->IsMapped());
+    EXPECT_EQ(source, buffer->GetBuffer());
+    EXPECT_EQ('\0', buffer->GetBuffer().data()[size]);
+
+    jcc::Lexer lexer{source_mgr_,
+                     source_mgr_.AddBuffer(path, buffer->GetBuffer()), idents_};
+    if (size != 0) {
+      EXPECT_EQ(jcc::TokenKind::Identifier, lexer.Lex().GetKind());
+    }
+    EXPECT_EQ(jcc::TokenKind::Eof, lexer.Lex().GetKind());
+  }
+  std::remove(path.c_str());
+  EXPECT_EQ(nullptr, jcc::MemoryBuffer::GetFile(path));
+}
+
+// Every scanner the CPU supports must agree with the scalar one, wherever the
+// run starts and ends relative to the vector blocks.
+TEST_F(LexerTest, CharScanner) {
+  using Kind = jcc::CharScanner::Kind;
+  const jcc::CharScanner* scalar = jcc::CharScanner::Get(Kind::Scalar);
+  ASSERT_NE(nullptr, scalar);
+
+  const std::string runs[] = {" \t\n\v\f\r", "_azAZqQ", "0123.9", "a*b/c*"};
+  const std::string stops[] = {"", "@", "[", "`", "{", "/", "*/", "\x80", "9"};
+  for (Kind kind : {Kind::SSE2, Kind::AVX2}) {
+    const jcc::CharScanner* scanner = jcc::CharScanner::Get(kind);
+    if (scanner == nullptr) {
+      continue;
+    }
+    for (const std::string& run : runs) {
+      for (const std::string& stop : stops) {
+        for (std::size_t prefix = 0; prefix < 40; prefix++) {
+          for (std::size_t repeat = 0; repeat < 12; repeat++) {
+            std::string buffer(prefix, '#');
+            for (std::size_t i = 0; i < repeat; i++) {
+              buffer += run;
+            }
+            buffer += stop;
+            const char* begin = buffer.c_str() + prefix;
+            EXPECT_EQ(scalar->SkipWhitespace(begin),
+                      scanner->SkipWhitespace(begin));
+            EXPECT_EQ(scalar->SkipIdentifier(begin),
+                      scanner->SkipIdentifier(begin));
+            EXPECT_EQ(scalar->SkipDigits(begin), scanner->SkipDigits(begin));
+            EXPECT_EQ(scalar->FindCommentEnd(begin),
+                      scanner->FindCommentEnd(begin));
+          }
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,60 @@
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "jcc/identifier_table.h"
+#include "jcc/scoped_table.h"
+
+TEST(ScopedTableTest, Shadowing) {
+  jcc::IdentifierTable idents;
+  const jcc::IdentifierInfo* x = &idents.Get("x");
+  const jcc::IdentifierInfo* y = &idents.Get("y");
+  int outer = 0;
+  int inner = 0;
+
+  jcc::ScopedTable<int> table;
+  table.EnterScope();
+  table.Insert(x, &outer);
+  EXPECT_EQ(&outer, table.Lookup(x));
+  EXPECT_EQ(nullptr, table.Lookup(y));
+
+  table.EnterScope();
+  table.Insert(x, &inner);
+  table.Insert(y, &inner);
+  EXPECT_EQ(&inner, table.Lookup(x));
+  EXPECT_EQ(&inner, table.Lookup(y));
+  table.ExitScope();
+
+  EXPECT_EQ(&outer, table.Lookup(x));
+  EXPECT_EQ(nullptr, table.Lookup(y));
+  table.ExitScope();
+  EXPECT_EQ(nullptr, table.Lookup(x));
+}
+
+// Enough names to make the table grow a few times while scopes are open.
+TEST(ScopedTableTest, Grow) {
+  jcc::IdentifierTable idents;
+  std::vector<const jcc::IdentifierInfo*> names;
+  for (int i = 0; i < 1000; i++) {
+    names.push_back(&idents.Get("v" + std::to_string(i)));
+  }
+  std::vector<int> values(names.size());
+
+  jcc::ScopedTable<int> table;
+  table.EnterScope();
+  for (std::size_t i = 0; i < names.size(); i++) {
+    if (i % 100 == 0) {
+      table.EnterScope();
+    }
+    table.Insert(names[i], &values[i]);
+  }
+  for (std::size_t i = 0; i < names.size(); i++) {
+    EXPECT_EQ(&values[i], table.Lookup(names[i]));
+  }
+  while (table.GetDepth() > 1) {
+    table.ExitScope();
+  }
+  for (const jcc::IdentifierInfo* name : names) {
+    EXPECT_EQ(nullptr, table.Lookup(name));
+  }
+}
@@ -0,0 +1,97 @@
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "c_generator.h"
+#include "gtest/gtest.h"
+#include "jcc/ast_dumper.h"
+#include "jcc/decl.h"
+#include "jcc/identifier_table.h"
+#include "jcc/lexer.h"
+#include "jcc/parser.h"
+#include "jcc/source_manager.h"
+#include "jcc/spsc_queue.h"
+
+TEST(SPSCQueueTest, FullAndEmpty) {
+  jcc::SPSCQueue<int, 4> queue;
+  int value = 0;
+  EXPECT_FALSE(queue.TryPop(value));
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(queue.TryPush(i));
+  }
+  EXPECT_FALSE(queue.TryPush(4));
+
+  // Room for exactly one more once one is popped.
+  ASSERT_TRUE(queue.TryPop(value));
+  EXPECT_EQ(0, value);
+  EXPECT_TRUE(queue.TryPush(4));
+  EXPECT_FALSE(queue.TryPush(5));
+
+  for (int i = 1; i <= 4; i++) {
+    ASSERT_TRUE(queue.TryPop(value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(queue.TryPop(value));
+}
+
+// Many times the capacity goes through, so the indices wrap around the
+// slots over and over, and everything must come out in order.
+TEST(SPSCQueueTest, ProducerConsumer) {
+  constexpr std::size_t count = 100000;
+  jcc::SPSCQueue<std::size_t, 16> queue;
+  std::vector<std::size_t> popped;
+  popped.reserve(count);
+  {
+    std::jthread consumer([&] {
+      for (std::size_t i = 0; i < count; i++) {
+        popped.push_back(queue.Pop());
+      }
+    });
+    std::jthread producer([&] {
+      for (std::size_t i = 0; i < count; i++) {
+        queue.Push(i);
+      }
+    });
+  }
+  ASSERT_EQ(count, popped.size());
+  for (std::size_t i = 0; i < count; i++) {
+    ASSERT_EQ(i, popped[i]);
+  }
+}
+
+// Returns what --ast-dump prints for `source`, lexing it on a thread of
+// its own ahead of the parser if `pipelined`.
+static std::string DumpAST(const std::string& source, bool pipelined) {
+  jcc::SourceManager source_mgr;
+  jcc::IdentifierTable idents;
+  jcc::Lexer lexer(source_mgr, source_mgr.AddBuffer("test.c", source), idents);
+  // The AST lives as long as the parser does.
+  auto dump = [](jcc::Parser& parser) {
+    std::vector<jcc::Decl*> decls = parser.ParseTranslateUnit();
+    testing::internal::CaptureStdout();
+    jcc::ASTDumper dumper;
+    for (jcc::Decl* decl : decls) {
+      dumper.Visit(decl);
+    }
+    return testing::internal::GetCapturedStdout();
+  };
+  if (!pipelined) {
+    jcc::Parser parser(lexer);
+    return dump(parser);
+  }
+  jcc::TokenQueue queue;
+  std::jthread lexer_thread([&] { lexer.LexAll(queue); });
+  jcc::Parser parser(lexer, queue);
+  return dump(parser);
+}
+
+// The program is many times the size of a TokenQueue, so the parser has to
+// keep up with the lexer thread for the whole of it.
+TEST(SPSCQueueTest, PipelinedParse) {
+  jcc::GeneratorOptions options;
+  const std::string source = jcc::GenerateProgram(options).source;
+  const std::string expected = DumpAST(source, false);
+  EXPECT_FALSE(expected.empty());
+  EXPECT_EQ(expected, DumpAST(source, true));
+}